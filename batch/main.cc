@@ -0,0 +1,303 @@
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "capture.h"
+#include "emulator.h"
+#include "framebuffer.h"
+#include "headless.h"
+#include "input_trace.h"
+#include "profiler.h"
+#include "work_stealing_pool.h"
+
+namespace {
+
+// One line of the manifest: `<rom>\t<InputTrace file or ->\t<cycle budget>[\t<seed>]`. The seed defaults
+// to the one the trace was recorded with, or 0 without a trace, so every job is reproducible regardless of
+// the thread that runs it. Jobs run at the clock speed of their trace, or the default one. Blank lines and
+// lines starting with '#' are ignored.
+struct Job {
+  std::string rom;
+  std::string trace;
+  uint64_t cycles;
+  std::optional<uint64_t> seed;
+  // Where the video of the job goes, as a CaptureWriter and a RawFrameWriter stream. Empty if not captured.
+  std::string capture;
+  std::string raw_capture;
+};
+
+struct Result {
+  uint64_t cycles{ 0 };
+  uint64_t frames{ 0 };
+  size_t draws{ 0 };
+  size_t beeps{ 0 };
+  uint64_t framebuffer_hash{ 0 };
+  // Chains the framebuffer hash of every frame, so it changes if any frame of the run shows something else.
+  uint64_t frames_hash{ 0 };
+  std::string error;
+  // ProfileToJson of the run, only filled in when the core is built with CHIP8_PROFILE.
+  std::string profile;
+};
+
+std::vector<Job> LoadManifest(const std::string& filename) {
+  std::ifstream manifest{ filename };
+  if (!manifest) {
+    throw std::invalid_argument{ "failed to open manifest" };
+  }
+
+  std::vector<Job> jobs;
+  std::string line;
+  while (std::getline(manifest, line)) {
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream fields{ line };
+    Job job;
+    std::string cycles;
+    std::string seed;
+    if (!std::getline(fields, job.rom, '\t') || !std::getline(fields, job.trace, '\t') ||
+        !std::getline(fields, cycles, '\t')) {
+      throw std::invalid_argument{ "malformed manifest line: " + line };
+    }
+    job.cycles = std::stoull(cycles);
+    if (std::getline(fields, seed)) {
+      job.seed = std::stoull(seed);
+    }
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+// Emulator and devices of a job, kept alive across the slices the job runs in.
+struct JobRun {
+  explicit JobRun(const Job& job)
+      : trace{ job.trace == "-" ? chip8::InputTrace{} : chip8::InputTrace::Load(job.trace) },
+        setup{ Setup(job, trace) },
+        keyboard{ trace, setup },
+        emulator{ job.rom,
+                  screen,
+                  speaker,
+                  keyboard,
+                  setup.clock_speed,
+                  chip8::Emulator::Mode::kTurbo,
+                  chip8::Emulator::Engine::kPredecoded } {
+    emulator.Seed(setup.seed);
+    if (!job.capture.empty()) {
+      capture.emplace(capture_stream);
+    }
+    if (!job.raw_capture.empty()) {
+      raw_capture_file.open(job.raw_capture, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!raw_capture_file) {
+        throw std::invalid_argument{ "failed to open " + job.raw_capture };
+      }
+      raw_capture.emplace(raw_capture_file);
+    }
+  }
+
+  // Hashes and captures what frame `frame` ended up showing. The screen is only redrawn when the picture
+  // changed, so most frames reuse the previous hash and write nothing.
+  void OnFrame(uint64_t frame) {
+    if (screen.DrawCount() != draws) {
+      draws = screen.DrawCount();
+      framebuffer_hash = chip8::HashFramebuffer(screen.Frame());
+      if (capture.has_value()) capture->Write(frame, screen.Frame());
+      if (raw_capture.has_value()) raw_capture->Write(frame, screen.Frame());
+    }
+    frames_hash = (frames_hash ^ framebuffer_hash) * 0x100000001b3;
+  }
+
+  // Ends the captures of a run that lasted `frames` frames. The compressed capture stays in memory until
+  // then, so suspended jobs do not hold a file open each.
+  void Finish(const Job& job, uint64_t frames) {
+    if (capture.has_value()) {
+      capture->Close(frames);
+      std::ofstream file{ job.capture, std::ios::out | std::ios::binary | std::ios::trunc };
+      file << capture_stream.rdbuf();
+      if (!file.good()) {
+        throw std::runtime_error{ "Error writing " + job.capture };
+      }
+    }
+    if (raw_capture.has_value()) raw_capture->Close(frames);
+  }
+
+  // What the job runs under. Jobs only run chip8::Emulator, so a trace recorded under another quirks profile
+  // is rejected.
+  static chip8::InputTrace::Setup Setup(const Job& job, const chip8::InputTrace& trace) {
+    const std::optional<chip8::InputTrace::Setup>& recorded{ trace.GetSetup() };
+    return { .seed = job.seed.value_or(recorded ? recorded->seed : 0),
+             .clock_speed = recorded ? recorded->clock_speed : chip8::Emulator::kChip8DefaultClockSpeed,
+             .quirks = "modern" };
+  }
+
+  const chip8::InputTrace trace;
+  const chip8::InputTrace::Setup setup;
+  chip8::MemoryScreen screen;
+  chip8::NullSpeaker speaker;
+  chip8::InputPlayer keyboard;
+  chip8::Emulator emulator;
+
+  size_t draws{ 0 };
+  uint64_t framebuffer_hash{ chip8::HashFramebuffer(chip8::Framebuffer{}) };
+  uint64_t frames_hash{ chip8::kFramebufferHashSeed };
+
+  std::stringstream capture_stream;
+  std::optional<chip8::CaptureWriter> capture;
+  std::ofstream raw_capture_file;
+  std::optional<chip8::RawFrameWriter> raw_capture;
+};
+
+// Runs `job` until its cycle budget is spent. After every frame that leaves the program waiting for a key
+// with no trace input due to end the wait, the job yields its worker to the other queued jobs and continues
+// from `run` when it is picked up again, so parked jobs only run one frame per turn.
+void RunJob(chip8::WorkStealingPool& pool, const Job& job, Result& result, std::shared_ptr<JobRun> run) {
+  try {
+    if (run == nullptr) {
+      run = std::make_shared<JobRun>(job);
+    }
+
+    chip8::Emulator& emulator{ run->emulator };
+    while (emulator.Cycles() < job.cycles) {
+      emulator.RunFrame();
+      run->OnFrame(result.frames++);
+
+      if (emulator.IsWaitingForKey() && !run->keyboard.IsInputDue(result.frames) &&
+          emulator.Cycles() < job.cycles) {
+        pool.Yield([&pool, &job, &result, run] { RunJob(pool, job, result, run); });
+        return;
+      }
+    }
+
+    run->Finish(job, result.frames);
+    result.cycles = emulator.Cycles();
+    result.draws = run->screen.DrawCount();
+    result.beeps = run->speaker.BeepCount();
+    result.framebuffer_hash = run->framebuffer_hash;
+    result.frames_hash = run->frames_hash;
+#if defined(CHIP8_PROFILE)
+    result.profile = chip8::ProfileToJson(emulator.GetProfile());
+#endif
+  } catch (const std::exception& ex) {
+    result.error = ex.what();
+  }
+}
+
+std::string JobFile(const std::string& directory, size_t index, const std::string& extension) {
+  return (std::filesystem::path{ directory } / (std::to_string(index) + extension)).string();
+}
+
+std::string EscapeJson(const std::string& value) {
+  std::string escaped;
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char code[7];
+          std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+          escaped += code;
+        } else {
+          escaped += c;
+        }
+        break;
+    }
+  }
+  return escaped;
+}
+
+void PrintResult(size_t index, const Job& job, const Result& result) {
+  std::printf(
+      "{\"job\":%zu,\"rom\":\"%s\",\"trace\":\"%s\",\"cycles\":%llu,\"frames\":%llu,\"draws\":%zu,"
+      "\"beeps\":%zu,\"framebuffer_hash\":\"%016llx\",\"frames_hash\":\"%016llx\",\"error\":\"%s\"%s%s}\n",
+      index, EscapeJson(job.rom).c_str(), EscapeJson(job.trace).c_str(),
+      static_cast<unsigned long long>(result.cycles), static_cast<unsigned long long>(result.frames),
+      result.draws, result.beeps, static_cast<unsigned long long>(result.framebuffer_hash),
+      static_cast<unsigned long long>(result.frames_hash), EscapeJson(result.error).c_str(),
+      result.profile.empty() ? "" : ",\"profile\":", result.profile.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  // `--capture=<directory>` writes the video of job N to `<directory>/N.c8fc` as a CaptureWriter stream,
+  // `--raw-capture=<directory>` to `<directory>/N.gray` as a RawFrameWriter stream, e.g. for an encoder
+  // reading from named pipes created there beforehand. Both may appear anywhere; the rest are positional.
+  std::vector<std::string> args;
+  std::string capture_dir;
+  std::string raw_capture_dir;
+  for (int i = 0; i < argc; ++i) {
+    std::string arg{ argv[i] };
+    if (arg.starts_with("--capture=")) {
+      capture_dir = arg.substr(10);
+    } else if (arg.starts_with("--raw-capture=")) {
+      raw_capture_dir = arg.substr(14);
+    } else {
+      args.push_back(arg);
+    }
+  }
+  // hardware_concurrency is 0 when it cannot tell.
+  size_t threads{ std::max(std::thread::hardware_concurrency(), 1u) };
+  bool valid{ args.size() >= 2 };
+  if (valid && args.size() >= 3) {
+    const std::string& count{ args[2] };
+    const auto [end, error]{ std::from_chars(count.data(), count.data() + count.size(), threads) };
+    valid = error == std::errc{} && end == count.data() + count.size() && threads > 0;
+  }
+  if (!valid) {
+    spdlog::error("usage: chip8_batch [--capture=<dir>] [--raw-capture=<dir>] <manifest> [threads]");
+    return 1;
+  }
+
+  try {
+    std::vector<Job> jobs{ LoadManifest(args[1]) };
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (!capture_dir.empty()) jobs[i].capture = JobFile(capture_dir, i, ".c8fc");
+      if (!raw_capture_dir.empty()) jobs[i].raw_capture = JobFile(raw_capture_dir, i, ".gray");
+    }
+    std::vector<Result> results(jobs.size());
+
+    const auto start{ std::chrono::steady_clock::now() };
+    {
+      chip8::WorkStealingPool pool{ threads };
+      for (size_t i = 0; i < jobs.size(); ++i) {
+        pool.Submit([&pool, &jobs, &results, i] { RunJob(pool, jobs[i], results[i], nullptr); });
+      }
+      pool.Wait();
+    }
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      PrintResult(i, jobs[i], results[i]);
+    }
+    spdlog::info("ran {} jobs on {} threads in {:.3f}s", jobs.size(), threads, elapsed.count());
+  } catch (const std::exception& ex) {
+    spdlog::error("unexpected exception: {}", ex.what());
+    return 1;
+  }
+}
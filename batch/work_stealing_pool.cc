@@ -0,0 +1,137 @@
+#include "work_stealing_pool.h"
+
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace chip8 {
+
+namespace {
+
+// Pool and deque index of the worker running on this thread, if any.
+thread_local const WorkStealingPool* current_pool{ nullptr };
+thread_local size_t current_worker{ 0 };
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+  if (threads == 0) threads = 1;
+
+  for (size_t i = 0; i < threads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+};
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard lock{ wake_mutex_ };
+    stop_ = true;
+  }
+  wake_.notify_all();
+
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+};
+
+void WorkStealingPool::Submit(Task task) { Enqueue(std::move(task), false); };
+
+void WorkStealingPool::Yield(Task task) { Enqueue(std::move(task), true); };
+
+void WorkStealingPool::Enqueue(Task task, bool behind) {
+  {
+    std::lock_guard lock{ done_mutex_ };
+    ++pending_;
+  }
+
+  const bool own_queue{ current_pool == this };
+  const size_t index{ own_queue ? current_worker : next_queue_++ % queues_.size() };
+  {
+    // The owner pops from the back and thieves steal from the front.
+    std::lock_guard lock{ queues_[index]->mutex };
+    if (behind && own_queue) {
+      queues_[index]->tasks.push_front(std::move(task));
+    } else {
+      queues_[index]->tasks.push_back(std::move(task));
+    }
+  }
+
+  {
+    std::lock_guard lock{ wake_mutex_ };
+    ++queued_;
+  }
+  wake_.notify_one();
+};
+
+void WorkStealingPool::Wait() {
+  std::unique_lock lock{ done_mutex_ };
+  done_.wait(lock, [this] { return pending_ == 0; });
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+};
+
+void WorkStealingPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  current_worker = index;
+
+  while (true) {
+    std::optional<Task> task{ Pop(index) };
+    if (!task.has_value()) task = Steal(index);
+
+    if (!task.has_value()) {
+      std::unique_lock lock{ wake_mutex_ };
+      wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+      if (stop_) return;
+      continue;
+    }
+
+    {
+      std::lock_guard lock{ wake_mutex_ };
+      --queued_;
+    }
+
+    // An escaping exception would otherwise end the process, and leave the task pending forever.
+    std::exception_ptr error;
+    try {
+      (*task)();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    std::lock_guard lock{ done_mutex_ };
+    if (error && !error_) error_ = error;
+    if (--pending_ == 0) done_.notify_all();
+  }
+};
+
+std::optional<WorkStealingPool::Task> WorkStealingPool::Pop(size_t index) {
+  Queue& queue{ *queues_[index] };
+  std::lock_guard lock{ queue.mutex };
+  if (queue.tasks.empty()) return std::nullopt;
+
+  Task task{ std::move(queue.tasks.back()) };
+  queue.tasks.pop_back();
+  return task;
+};
+
+std::optional<WorkStealingPool::Task> WorkStealingPool::Steal(size_t thief) {
+  for (size_t offset = 1; offset < queues_.size(); ++offset) {
+    Queue& queue{ *queues_[(thief + offset) % queues_.size()] };
+    std::lock_guard lock{ queue.mutex };
+    if (queue.tasks.empty()) continue;
+
+    Task task{ std::move(queue.tasks.front()) };
+    queue.tasks.pop_front();
+    return task;
+  }
+  return std::nullopt;
+};
+
+}  // namespace chip8
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace chip8 {
+
+// Fixed-size thread pool with one task deque per worker. A worker runs the newest task of its own deque and,
+// once that is empty, steals the oldest task of another worker's deque, so uneven jobs balance themselves
+// across cores without a single contended queue.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(size_t threads);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  // Tasks submitted from a worker go to that worker's own deque; others are spread round-robin.
+  void Submit(Task task);
+
+  // Like Submit, but from a worker the task is queued behind every other task of that worker's deque, where
+  // it runs last and is the first to be stolen. Lets a task give up its thread and continue later.
+  void Yield(Task task);
+
+  // Blocks until every submitted task, including tasks submitted by tasks, has finished. Rethrows the first
+  // exception that escaped a task since the last call; the other tasks still run to completion.
+  void Wait();
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void Enqueue(Task task, bool behind);
+  void WorkerLoop(size_t index);
+  std::optional<Task> Pop(size_t index);
+  std::optional<Task> Steal(size_t thief);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> next_queue_{ 0 };
+
+  // Tasks sitting in a deque, guarded by wake_mutex_ so idle workers cannot miss a wake-up.
+  size_t queued_{ 0 };
+  bool stop_{ false };
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+
+  // Tasks submitted but not yet finished, and the first exception one of them threw.
+  size_t pending_{ 0 };
+  std::exception_ptr error_;
+  std::mutex done_mutex_;
+  std::condition_variable done_;
+};
+
+}  // namespace chip8
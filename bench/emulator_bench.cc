@@ -0,0 +1,266 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+#include "headless.h"
+#include "lockstep.h"
+#include "rewind.h"
+
+namespace {
+
+const std::string kProgramsDir{ CHIP8_PROGRAMS_DIR };
+const std::string kMicroBenchmarkRom{ kProgramsDir + "/LogoIBM.ch8" };
+
+void BM_Decode(benchmark::State& state) {
+  std::array<uint8_t, 2> instr{ 0xD1, 0x25 };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(instr);
+    benchmark::DoNotOptimize(chip8::Emulator::Decode(instr));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Decode);
+
+// One representative opcode per group; the argument is the raw opcode.
+void BM_Execute(benchmark::State& state) {
+  chip8::MemoryScreen screen;
+  chip8::NullSpeaker speaker;
+  chip8::MemoryKeyboard keyboard;
+  chip8::Emulator emulator{ kMicroBenchmarkRom, screen, speaker, keyboard };
+
+  const auto opcode{ static_cast<uint16_t>(state.range(0)) };
+  emulator.ExecuteOpcode(0xA300);  // point I at free memory for the FX33/FX55/FX65 group
+  for (auto _ : state) {
+    emulator.ExecuteOpcode(opcode);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Execute)
+    ->ArgName("opcode")
+    ->Arg(0x1200)   // jump
+    ->Arg(0x3012)   // skip if Vx == NN
+    ->Arg(0x6012)   // set Vx
+    ->Arg(0x7001)   // add to Vx
+    ->Arg(0x8014)   // add Vy to Vx with carry
+    ->Arg(0x801E)   // shift left
+    ->Arg(0xA300)   // set I
+    ->Arg(0xC0FF)   // random
+    ->Arg(0xE09E)   // skip if key pressed
+    ->Arg(0xF015)   // set delay timer
+    ->Arg(0xF033)   // BCD
+    ->Arg(0xF555)   // store V0..V5
+    ->Arg(0xF565);  // load V0..V5
+
+// Sprite blit of `n` rows, alternating positions so both aligned and straddling words are covered.
+void BM_Display(benchmark::State& state) {
+  chip8::MemoryScreen screen;
+  chip8::NullSpeaker speaker;
+  chip8::MemoryKeyboard keyboard;
+  chip8::Emulator emulator{ kMicroBenchmarkRom, screen, speaker, keyboard };
+
+  const auto n{ static_cast<uint16_t>(state.range(0)) };
+  emulator.ExecuteOpcode(0xA000);  // font sprites
+  emulator.ExecuteOpcode(0x6003);
+  emulator.ExecuteOpcode(0x610A);
+  for (auto _ : state) {
+    emulator.ExecuteOpcode(0xD010 | n);
+    emulator.ExecuteOpcode(0x7005);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Display)->ArgName("rows")->Arg(1)->Arg(5)->Arg(15);
+
+void BM_ClearScreen(benchmark::State& state) {
+  chip8::MemoryScreen screen;
+  chip8::NullSpeaker speaker;
+  chip8::MemoryKeyboard keyboard;
+  chip8::Emulator emulator{ kMicroBenchmarkRom, screen, speaker, keyboard };
+
+  for (auto _ : state) {
+    emulator.ExecuteOpcode(0x00E0);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ClearScreen);
+
+// Forks an emulator that has run for a second, as a tree search does at every node.
+void BM_Fork(benchmark::State& state) {
+  chip8::MemoryScreen screen;
+  chip8::NullSpeaker speaker;
+  chip8::MemoryKeyboard keyboard;
+  chip8::Emulator parent{ kMicroBenchmarkRom,
+                          screen,
+                          speaker,
+                          keyboard,
+                          chip8::Emulator::kChip8DefaultClockSpeed,
+                          chip8::Emulator::Mode::kTurbo };
+  for (int frame = 0; frame < 60; ++frame) {
+    parent.RunFrame();
+  }
+
+  for (auto _ : state) {
+    chip8::Emulator fork{ parent, screen, speaker, keyboard };
+    benchmark::DoNotOptimize(fork);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Fork);
+
+// Runs frames of an animated demo with (range(0) == 1) and without rewind recording, to measure what
+// recording adds per frame. A turbo frame is only a dozen instructions, so compare the two as a ratio rather
+// than against the 16.7 ms of a real time frame.
+void BM_RunFrame(benchmark::State& state) {
+  chip8::MemoryScreen screen;
+  chip8::NullSpeaker speaker;
+  chip8::MemoryKeyboard keyboard;
+  chip8::Emulator emulator{ kProgramsDir + "/Trip8Demo.ch8",
+                            screen,
+                            speaker,
+                            keyboard,
+                            chip8::Emulator::kChip8DefaultClockSpeed,
+                            chip8::Emulator::Mode::kTurbo,
+                            chip8::Emulator::Engine::kPredecoded };
+  chip8::RewindBuffer rewind;
+  if (state.range(0) == 1) {
+    emulator.AttachRewindBuffer(&rewind);
+  }
+
+  for (auto _ : state) {
+    emulator.RunFrame();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RunFrame)->ArgName("rewind")->Arg(0)->Arg(1);
+
+// Runs `rom` headless in turbo mode for range(0) million cycles per iteration on engine range(1) and
+// reports the achieved instruction rate.
+void BM_Rom(benchmark::State& state, const std::string& rom) {
+  const auto cycles{ static_cast<uint64_t>(state.range(0)) * 1'000'000 };
+  const auto engine{ static_cast<chip8::Emulator::Engine>(state.range(1)) };
+
+  uint64_t executed{ 0 };
+  for (auto _ : state) {
+    state.PauseTiming();
+    chip8::MemoryScreen screen;
+    chip8::NullSpeaker speaker;
+    chip8::MemoryKeyboard keyboard;
+    chip8::Emulator emulator{ rom,
+                              screen,
+                              speaker,
+                              keyboard,
+                              chip8::Emulator::kChip8DefaultClockSpeed,
+                              chip8::Emulator::Mode::kTurbo,
+                              engine };
+    emulator.Seed(0);
+    state.ResumeTiming();
+
+    while (emulator.Cycles() < cycles) {
+      emulator.RunFrame();
+    }
+    executed += emulator.Cycles();
+  }
+  state.counters["instr/s"] = benchmark::Counter(static_cast<double>(executed), benchmark::Counter::kIsRate);
+}
+
+// Keypad of `lane` during `frame`: one key held at a time, cycling at a lane-dependent phase so lanes of the
+// same ROM diverge.
+uint16_t LaneKeys(size_t lane, uint64_t frame) {
+  return static_cast<uint16_t>(1 << ((frame / 20 + lane) % 16));
+}
+
+// Runs `lanes` lanes of `rom` next to one scalar Emulator per lane for `frames` frames and reports whether
+// all of them ended in the same state.
+bool LockstepMatchesScalar(const std::string& rom, size_t lanes, uint64_t frames) {
+  chip8::LockstepEngine lockstep{ rom, lanes };
+
+  std::vector<chip8::MemoryScreen> screens(lanes);
+  std::vector<chip8::NullSpeaker> speakers(lanes);
+  std::vector<chip8::MemoryKeyboard> keyboards(lanes);
+  std::vector<chip8::Emulator> emulators;
+  emulators.reserve(lanes);
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    emulators.emplace_back(rom, screens[lane], speakers[lane], keyboards[lane],
+                           chip8::Emulator::kChip8DefaultClockSpeed, chip8::Emulator::Mode::kTurbo);
+    emulators.back().Seed(lane);
+  }
+
+  for (uint64_t frame = 0; frame < frames; ++frame) {
+    for (size_t lane = 0; lane < lanes; ++lane) {
+      lockstep.SetKeys(lane, LaneKeys(lane, frame));
+      keyboards[lane].SetKeys(LaneKeys(lane, frame));
+      emulators[lane].RunFrame();
+    }
+    lockstep.RunFrame();
+  }
+
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    if (!(lockstep.CaptureState(lane) == emulators[lane].CaptureState())) return false;
+  }
+  return true;
+}
+
+// Steps range(0) lanes of `rom` in lockstep for 60 frames per iteration and reports instructions per second
+// summed over all lanes.
+void BM_Lockstep(benchmark::State& state, const std::string& rom) {
+  const auto lanes{ static_cast<size_t>(state.range(0)) };
+  if (!LockstepMatchesScalar(rom, 16, 600)) {
+    state.SkipWithError("lockstep engine diverged from the scalar emulator");
+    return;
+  }
+
+  uint64_t executed{ 0 };
+  for (auto _ : state) {
+    state.PauseTiming();
+    chip8::LockstepEngine lockstep{ rom, lanes };
+    state.ResumeTiming();
+
+    for (uint64_t frame = 0; frame < 60; ++frame) {
+      for (size_t lane = 0; lane < lanes; ++lane) {
+        lockstep.SetKeys(lane, LaneKeys(lane, frame));
+      }
+      lockstep.RunFrame();
+    }
+    executed += lockstep.Cycles() * lanes;
+  }
+  state.counters["instr/s"] = benchmark::Counter(static_cast<double>(executed), benchmark::Counter::kIsRate);
+}
+
+void RegisterRomBenchmarks() {
+  std::vector<std::filesystem::path> roms;
+  for (const auto& entry : std::filesystem::directory_iterator{ kProgramsDir }) {
+    if (entry.path().extension() == ".ch8") roms.push_back(entry.path());
+  }
+  std::sort(roms.begin(), roms.end());
+
+  for (const auto& rom : roms) {
+    benchmark::RegisterBenchmark(("BM_Rom/" + rom.stem().string()).c_str(), BM_Rom, rom.string())
+        ->ArgNames({ "mcycles", "engine" })
+        ->ArgsProduct({ { 1 },
+                        { static_cast<int64_t>(chip8::Emulator::Engine::kInterpreter),
+                          static_cast<int64_t>(chip8::Emulator::Engine::kPredecoded),
+                          static_cast<int64_t>(chip8::Emulator::Engine::kBlocks) } })
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_Lockstep/" + rom.stem().string()).c_str(), BM_Lockstep, rom.string())
+        ->ArgName("lanes")
+        ->Arg(64)
+        ->Arg(1024)
+        ->Unit(benchmark::kMillisecond);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  RegisterRomBenchmarks();
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
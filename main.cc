@@ -1,36 +1,135 @@
 #include <spdlog/spdlog.h>
 
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <string>
 
 #include "src/emulator.h"
-#include "src/keyboard.h"
-#include "src/screen.h"
-#include "src/speaker.h"
+#include "src/input_trace.h"
+#include "src/profiler.h"
+#include "src/quirks.h"
+#include "src/sfml/keyboard.h"
+#include "src/sfml/screen.h"
+#include "src/sfml/speaker.h"
+#include "src/telemetry.h"
+#include "src/threaded_frontend.h"
 
 int main(int argc, char* argv[]) {
-  std::vector<std::string> args(argv, argv + argc);
-  if (args.size() < 3) {
-    spdlog::error("must provide rom and beep sound file");
+  // `--record=<trace>`, `--replay=<trace>`, `--seed=<n>`, `--keymap=<host keys for 0-F>`,
+  // `--quirks=<modern|vip|schip|xochip>`, `--profile=<json>` and `--telemetry` may appear anywhere; the rest
+  // are positional.
+  std::vector<std::string> args;
+  std::string record_file;
+  std::string replay_file;
+  std::string seed;
+  std::string key_map;
+  std::string quirks;
+  std::string profile_file;
+  bool show_telemetry{ false };
+  for (int i = 0; i < argc; ++i) {
+    std::string arg{ argv[i] };
+    if (arg.starts_with("--record=")) {
+      record_file = arg.substr(9);
+    } else if (arg.starts_with("--replay=")) {
+      replay_file = arg.substr(9);
+    } else if (arg.starts_with("--seed=")) {
+      seed = arg.substr(7);
+    } else if (arg.starts_with("--keymap=")) {
+      key_map = arg.substr(9);
+    } else if (arg.starts_with("--quirks=")) {
+      quirks = arg.substr(9);
+    } else if (arg.starts_with("--profile=")) {
+      profile_file = arg.substr(10);
+    } else if (arg == "--telemetry") {
+      show_telemetry = true;
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() < 2) {
+    spdlog::error("must provide rom");
     return 1;
   }
 
-  std::string sound_file{ args[2] };
-  chip8::Speaker speaker{ sound_file };
+  std::optional<uint32_t> clock_speed;
+  if (args.size() >= 3) {
+    clock_speed = static_cast<uint32_t>(std::atoi(args[2].c_str()));
+  }
+  chip8::Emulator::Mode mode{ args.size() >= 4 && args[3] == "turbo" ? chip8::Emulator::Mode::kTurbo
+                                                                     : chip8::Emulator::Mode::kRealtime };
+
+  try {
+    chip8::SfmlSpeaker speaker;
+    chip8::SfmlScreen screen;
+    chip8::SfmlKeyboard live_keyboard{ screen, key_map.empty() ? chip8::SfmlKeyboard::kDefaultKeyMap
+                                                                : chip8::SfmlKeyboard::ParseKeyMap(key_map) };
 
-  std::chrono::microseconds delay{ args.size() >= 4 ? std::atoi(args[3].c_str()) : 500 };
+    chip8::InputTrace trace{ replay_file.empty() ? chip8::InputTrace{}
+                                                 : chip8::InputTrace::Load(replay_file) };
+    // A replay runs under the setup it was recorded with; options given explicitly must match it, which the
+    // player checks. Recordings always pick a seed, so they can be replayed.
+    if (const std::optional<chip8::InputTrace::Setup>& recorded{ trace.GetSetup() }) {
+      if (seed.empty()) seed = std::to_string(recorded->seed);
+      if (!clock_speed.has_value()) clock_speed = recorded->clock_speed;
+      if (quirks.empty()) quirks = recorded->quirks;
+    }
+    if (seed.empty() && !record_file.empty()) {
+      seed = std::to_string(std::random_device{}());
+    }
+    if (quirks.empty()) quirks = "modern";
+    const chip8::InputTrace::Setup setup{
+      .seed = seed.empty() ? 0 : std::stoull(seed),
+      .clock_speed = clock_speed.value_or(chip8::Emulator::kChip8DefaultClockSpeed),
+      .quirks = quirks,
+    };
+    if (!record_file.empty()) trace.SetSetup(setup);
 
-  chip8::Screen screen;
-  std::string rom_file{ args[1] };
-  chip8::Emulator emulator{ rom_file, screen, speaker, delay };
+    chip8::InputRecorder recorder{ live_keyboard, trace };
+    std::optional<chip8::InputPlayer> player;
+    if (!replay_file.empty()) player.emplace(trace, setup);
+    chip8::Keyboard& keyboard{ player.has_value()     ? static_cast<chip8::Keyboard&>(*player)
+                               : !record_file.empty() ? static_cast<chip8::Keyboard&>(recorder)
+                                                      : live_keyboard };
 
-  try {
-    emulator.StartExecutionLoop();
+    std::string rom_file{ args[1] };
+    // The emulator runs on its own thread, drawing into `frames`; this thread keeps the window.
+    chip8::FrameHandoff frames;
+    chip8::Telemetry telemetry;
+
+    chip8::VisitQuirksProfile(quirks, [&](auto profile) {
+      using Emulator = chip8::BasicEmulator<decltype(profile)::kQuirks>;
+      Emulator emulator{ rom_file, frames, speaker, keyboard, setup.clock_speed, mode };
+      if (!seed.empty()) {
+        emulator.Seed(setup.seed);
+        spdlog::info("seed {}", seed);
+      }
+
+      chip8::RunEmulationThread(emulator, frames, screen, show_telemetry ? &telemetry : nullptr);
+
+#if defined(CHIP8_PROFILE)
+      chip8::LogProfile(emulator.GetProfile());
+      if (!profile_file.empty()) {
+        std::ofstream{ profile_file } << chip8::ProfileToJson(emulator.GetProfile()) << '\n';
+      }
+#endif
+    });
+
+#if !defined(CHIP8_PROFILE)
+    if (!profile_file.empty()) {
+      spdlog::warn("--profile needs a build with CHIP8_PROFILE=ON, no profile written");
+    }
+#endif
+
+    if (!record_file.empty()) {
+      trace.Save(record_file);
+      spdlog::info("recorded {} input events to {}", trace.Events().size(), record_file);
+    }
   } catch (const std::exception& ex) {
     spdlog::error("unexpected exception: {}", ex.what());
   }
 
   spdlog::info("bye!");
 }
-
@@ -0,0 +1,66 @@
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+#include "quirks.h"
+#include "remote.h"
+#include "threaded_frontend.h"
+
+int main(int argc, char* argv[]) {
+  // `--quirks=<modern|vip|schip|xochip>` and `--seed=<n>` may appear anywhere; the rest are positional.
+  std::vector<std::string> args;
+  std::string quirks{ "modern" };
+  std::string seed;
+  for (int i = 0; i < argc; ++i) {
+    std::string arg{ argv[i] };
+    if (arg.starts_with("--quirks=")) {
+      quirks = arg.substr(9);
+    } else if (arg.starts_with("--seed=")) {
+      seed = arg.substr(7);
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() < 3) {
+    spdlog::error("usage: chip8_serve [--quirks=<profile>] [--seed=<n>] <rom> <port> [clock speed]");
+    return 1;
+  }
+
+  const uint16_t port{ static_cast<uint16_t>(std::stoul(args[2])) };
+  const uint32_t clock_speed{ args.size() >= 4 ? static_cast<uint32_t>(std::stoul(args[3]))
+                                               : chip8::Emulator::kChip8DefaultClockSpeed };
+
+  try {
+    chip8::RemoteScreen screen{ port };
+    chip8::RemoteKeyboard keyboard{ screen };
+    chip8::RemoteSpeaker speaker{ screen };
+
+    // The program only starts once someone is watching, and the run ends when they leave.
+    spdlog::info("waiting for a client on port {}", port);
+    screen.Accept();
+    spdlog::info("client connected");
+
+    chip8::FrameHandoff frames;
+    chip8::VisitQuirksProfile(quirks, [&](auto profile) {
+      using Emulator = chip8::BasicEmulator<decltype(profile)::kQuirks>;
+      Emulator emulator{ args[1], frames, speaker, keyboard, clock_speed, Emulator::Mode::kRealtime };
+      if (!seed.empty()) {
+        emulator.Seed(std::stoull(seed));
+      }
+
+      const auto start{ std::chrono::steady_clock::now() };
+      chip8::RunEmulationThread(emulator, frames, screen);
+      const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+      spdlog::info("sent {} bytes in {:.1f}s, {:.0f} bytes per second", screen.BytesSent(), elapsed.count(),
+                   screen.BytesSent() / elapsed.count());
+    });
+  } catch (const std::exception& ex) {
+    spdlog::error("unexpected exception: {}", ex.what());
+    return 1;
+  }
+}
@@ -0,0 +1,254 @@
+#include "capture.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "framebuffer.h"
+
+namespace chip8 {
+
+namespace {
+
+constexpr size_t kMaxFrameBytes{ kFramebufferWidth * kFramebufferHeight / 8 };
+
+// Unchanged bytes shorter than this between two changed ones in a record are stored as part of a single
+// changed run, which is smaller than starting a new pair of runs.
+constexpr size_t kMinUnchangedRun{ 3 };
+
+using FrameBytes = std::array<uint8_t, kMaxFrameBytes>;
+
+// Visible pixels of `framebuffer` packed 8 to a byte, row by row, with the leftmost pixel in the most
+// significant bit. Returns the number of bytes used.
+size_t PackFrame(const Framebuffer& framebuffer, FrameBytes& bytes) {
+  size_t size{ 0 };
+  const auto append_word{ [&](uint64_t word) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      bytes[size++] = static_cast<uint8_t>(word >> shift);
+    }
+  } };
+  for (size_t y = 0; y < framebuffer.Height(); ++y) {
+    append_word(framebuffer.left[y]);
+    if (framebuffer.hires) append_word(framebuffer.right[y]);
+  }
+  return size;
+}
+
+void UnpackFrame(const FrameBytes& bytes, Framebuffer& framebuffer) {
+  size_t offset{ 0 };
+  const auto next_word{ [&]() {
+    uint64_t word{ 0 };
+    for (int i = 0; i < 8; ++i) {
+      word = (word << 8) | bytes[offset++];
+    }
+    return word;
+  } };
+  for (size_t y = 0; y < framebuffer.Height(); ++y) {
+    framebuffer.left[y] = next_word();
+    if (framebuffer.hires) framebuffer.right[y] = next_word();
+  }
+}
+
+void AppendUint16(std::vector<uint8_t>& out, uint16_t value) {
+  out.push_back(static_cast<uint8_t>(value & 0xFF));
+  out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void AppendUint32(std::vector<uint8_t>& out, uint32_t value) {
+  AppendUint16(out, static_cast<uint16_t>(value & 0xFFFF));
+  AppendUint16(out, static_cast<uint16_t>(value >> 16));
+}
+
+void AppendLeb128(std::vector<uint8_t>& out, uint64_t value) {
+  do {
+    out.push_back(static_cast<uint8_t>((value & 0x7F) | (value > 0x7F ? 0x80 : 0)));
+    value >>= 7;
+  } while (value != 0);
+}
+
+void WriteBytes(std::ostream& out, const uint8_t* data, size_t size) {
+  out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+  if (!out.good()) {
+    throw std::runtime_error{ "Error writing capture" };
+  }
+}
+
+}  // namespace
+
+CaptureWriter::CaptureWriter(std::ostream& out) : out_{ out } {
+  AppendUint32(record_, kMagic);
+  AppendUint16(record_, kVersion);
+  Flush();
+};
+
+void CaptureWriter::Write(uint64_t frame, const Framebuffer& framebuffer) {
+  if (closed_) {
+    throw std::invalid_argument{ "capture is closed" };
+  }
+  if (frame_.has_value() && frame <= *frame_) {
+    throw std::invalid_argument{ "captured frames must be in frame order" };
+  }
+  frame_ = frame;
+  if (framebuffer == previous_) return;
+
+  if (framebuffer.hires != previous_.hires) {
+    previous_ = Framebuffer{ .hires = framebuffer.hires };
+  }
+  FrameBytes before;
+  FrameBytes after;
+  PackFrame(previous_, before);
+  const size_t size{ PackFrame(framebuffer, after) };
+
+  AppendLeb128(record_, frame - record_frame_);
+  record_.push_back(framebuffer.hires ? kHighRes : kLowRes);
+  size_t offset{ 0 };
+  while (offset < size) {
+    size_t unchanged{ 0 };
+    while (offset + unchanged < size && before[offset + unchanged] == after[offset + unchanged]) {
+      ++unchanged;
+    }
+    offset += unchanged;
+
+    // Extends the changed run over short unchanged gaps as long as another changed byte follows.
+    size_t changed{ 0 };
+    for (size_t gap = 0; offset + changed + gap < size && gap < kMinUnchangedRun;) {
+      if (before[offset + changed + gap] != after[offset + changed + gap]) {
+        changed += gap + 1;
+        gap = 0;
+      } else {
+        ++gap;
+      }
+    }
+
+    AppendLeb128(record_, unchanged);
+    AppendLeb128(record_, changed);
+    for (size_t i = offset; i < offset + changed; ++i) {
+      record_.push_back(before[i] ^ after[i]);
+    }
+    offset += changed;
+  }
+  Flush();
+
+  previous_ = framebuffer;
+  record_frame_ = frame;
+  ++record_count_;
+};
+
+void CaptureWriter::Close(uint64_t frames) {
+  if (closed_) return;
+  if (frame_.has_value() && frames <= *frame_) {
+    throw std::invalid_argument{ "capture must end after its last frame" };
+  }
+
+  AppendLeb128(record_, frames - record_frame_);
+  record_.push_back(kEnd);
+  Flush();
+  out_.flush();
+  closed_ = true;
+};
+
+void CaptureWriter::Flush() {
+  WriteBytes(out_, record_.data(), record_.size());
+  record_.clear();
+};
+
+CaptureReader::CaptureReader(std::istream& in) : in_{ in } {
+  uint32_t magic{ 0 };
+  for (int shift = 0; shift < 32; shift += 8) {
+    magic |= static_cast<uint32_t>(Byte()) << shift;
+  }
+  const uint8_t version_low{ Byte() };
+  const uint16_t version{ static_cast<uint16_t>(version_low | (Byte() << 8)) };
+  if (magic != CaptureWriter::kMagic || version != CaptureWriter::kVersion) {
+    throw std::invalid_argument{ "unsupported capture format" };
+  }
+};
+
+std::optional<CapturedFrame> CaptureReader::Next() {
+  if (frames_.has_value()) return std::nullopt;
+
+  frame_ += Leb128();
+  const uint8_t resolution{ Byte() };
+  if (resolution == CaptureWriter::kEnd) {
+    frames_ = frame_;
+    return std::nullopt;
+  }
+  if (resolution != CaptureWriter::kLowRes && resolution != CaptureWriter::kHighRes) {
+    throw std::invalid_argument{ "unknown capture resolution" };
+  }
+
+  const bool hires{ resolution == CaptureWriter::kHighRes };
+  if (hires != previous_.hires) {
+    previous_ = Framebuffer{ .hires = hires };
+  }
+  FrameBytes bytes;
+  const size_t size{ PackFrame(previous_, bytes) };
+  size_t offset{ 0 };
+  while (offset < size) {
+    const uint64_t unchanged{ Leb128() };
+    const uint64_t changed{ Leb128() };
+    if ((unchanged == 0 && changed == 0) || unchanged > size - offset ||
+        changed > size - offset - unchanged) {
+      throw std::invalid_argument{ "malformed capture record" };
+    }
+    offset += unchanged;
+    for (uint64_t i = 0; i < changed; ++i) {
+      bytes[offset++] ^= Byte();
+    }
+  }
+  UnpackFrame(bytes, previous_);
+  return CapturedFrame{ .frame = frame_, .framebuffer = previous_ };
+};
+
+uint8_t CaptureReader::Byte() {
+  const auto byte{ in_.get() };
+  if (byte == std::istream::traits_type::eof()) {
+    throw std::invalid_argument{ "truncated capture" };
+  }
+  return static_cast<uint8_t>(byte);
+};
+
+uint64_t CaptureReader::Leb128() {
+  uint64_t value{ 0 };
+  for (int shift = 0; shift < 64; shift += 7) {
+    const uint8_t byte{ Byte() };
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+  throw std::invalid_argument{ "malformed frame delta in capture" };
+};
+
+void RawFrameWriter::Write(uint64_t frame, const Framebuffer& framebuffer) {
+  if (frame < frame_) {
+    throw std::invalid_argument{ "captured frames must be in frame order" };
+  }
+  RepeatUntil(frame);
+
+  // Low resolution pixels cover 2x2 output pixels.
+  const size_t scale{ kFramebufferWidth / framebuffer.Width() };
+  for (size_t y = 0; y < kFramebufferHeight; ++y) {
+    for (size_t x = 0; x < kFramebufferWidth; ++x) {
+      pixels_[y * kFramebufferWidth + x] = IsPixelSet(framebuffer, x / scale, y / scale) ? 0xFF : 0x00;
+    }
+  }
+  WriteBytes(out_, pixels_.data(), pixels_.size());
+  frame_ = frame + 1;
+};
+
+void RawFrameWriter::Close(uint64_t frames) {
+  RepeatUntil(frames);
+  out_.flush();
+};
+
+void RawFrameWriter::RepeatUntil(uint64_t frame) {
+  for (; frame_ < frame; ++frame_) {
+    WriteBytes(out_, pixels_.data(), pixels_.size());
+  }
+};
+
+}  // namespace chip8
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "framebuffer.h"
+
+namespace chip8 {
+
+// Video of headless runs. The host hands the frames it runs to a FrameSink, which either compresses them
+// into a capture file or streams them raw to a tool such as a video encoder. Writing one image per frame
+// would cost far more than emulating it.
+
+class FrameSink {
+ public:
+  virtual ~FrameSink() = default;
+
+  // `framebuffer` is what the screen shows from emulated frame `frame` on, until the next write. Frames
+  // must be written in increasing order; the host may skip those in which nothing was drawn.
+  virtual void Write(uint64_t frame, const Framebuffer& framebuffer) = 0;
+
+  // Ends the capture of a run lasting `frames` frames. Nothing may be written afterwards.
+  virtual void Close(uint64_t frames) = 0;
+};
+
+// Compact capture of a run. Consecutive frames mostly differ in a few sprite bytes, so every frame is
+// stored as the XOR of its visible pixels with those of the frame before, run-length encoded, and frames
+// that show the same picture as the one before are not stored at all.
+//
+// The stream is a `C8FC` magic and version followed by one record per changed frame,
+// `<LEB128 frames since the previous record><resolution byte><runs>`, the first record counting from frame
+// 0 and its predecessor being a blank low resolution frame. The runs cover the visible pixels of the frame
+// row by row, packed 8 to a byte with the leftmost in the most significant bit, as pairs of
+// `<LEB128 unchanged bytes><LEB128 changed bytes>` each followed by the XOR of every changed byte, until they
+// add up to the size of the frame. A record whose resolution differs from its predecessor's is XORed with a
+// blank frame. The stream ends with a record of resolution kEnd and no runs, counting to the end of the run.
+class CaptureWriter : public FrameSink {
+ public:
+  static inline const uint32_t kMagic{ 0x43463843 };  // "C8FC" read as little endian
+  static inline const uint16_t kVersion{ 1 };
+
+  // Resolution byte of each record.
+  static inline const uint8_t kLowRes{ 0 };
+  static inline const uint8_t kHighRes{ 1 };
+  static inline const uint8_t kEnd{ 0xFF };
+
+  // Writes the header straight away. `out` must outlive the writer.
+  explicit CaptureWriter(std::ostream& out);
+
+  // Throws std::invalid_argument if `frame` does not come after the previous one, std::runtime_error if
+  // the stream fails.
+  void Write(uint64_t frame, const Framebuffer& framebuffer) override;
+  void Close(uint64_t frames) override;
+
+  // Records written so far, not counting the end.
+  size_t RecordCount() const { return record_count_; }
+
+ private:
+  void Flush();
+
+  std::ostream& out_;
+  std::vector<uint8_t> record_;
+  Framebuffer previous_{};
+  // Frame of the last write and of the last record.
+  std::optional<uint64_t> frame_;
+  uint64_t record_frame_{ 0 };
+  size_t record_count_{ 0 };
+  bool closed_{ false };
+};
+
+struct CapturedFrame {
+  uint64_t frame;
+  Framebuffer framebuffer;
+};
+
+// Decodes a CaptureWriter stream one stored frame at a time.
+class CaptureReader {
+ public:
+  // Reads the header straight away. Throws std::invalid_argument if `in` is not a capture.
+  explicit CaptureReader(std::istream& in);
+
+  // The next stored frame, or nullopt once the end record has been read. Throws std::invalid_argument on
+  // a malformed or truncated stream.
+  std::optional<CapturedFrame> Next();
+
+  // Length of the run in frames, known once Next has returned nullopt.
+  std::optional<uint64_t> Frames() const { return frames_; }
+
+ private:
+  uint8_t Byte();
+  uint64_t Leb128();
+
+  std::istream& in_;
+  Framebuffer previous_{};
+  uint64_t frame_{ 0 };
+  std::optional<uint64_t> frames_;
+};
+
+// Uncompressed video for external tools, one byte per pixel, 0 or 255. Every frame is kFramebufferWidth by
+// kFramebufferHeight, low resolution ones doubled in both directions, and skipped frames are repeated, so
+// the stream has the fixed geometry and rate an encoder expects, e.g. piped through a named pipe:
+//   ffmpeg -f rawvideo -pix_fmt gray -video_size 128x64 -framerate 60 -i <pipe> out.mp4
+class RawFrameWriter : public FrameSink {
+ public:
+  static inline const size_t kFrameSize{ kFramebufferWidth * kFramebufferHeight };
+
+  // `out` must outlive the writer.
+  explicit RawFrameWriter(std::ostream& out) : out_{ out } {};
+
+  // Throws std::invalid_argument if `frame` does not come after the previous one, std::runtime_error if
+  // the stream fails.
+  void Write(uint64_t frame, const Framebuffer& framebuffer) override;
+  void Close(uint64_t frames) override;
+
+ private:
+  // Repeats the current picture up to, not including, `frame`.
+  void RepeatUntil(uint64_t frame);
+
+  std::ostream& out_;
+  std::array<uint8_t, kFrameSize> pixels_{};
+  // Next frame to be written to the stream.
+  uint64_t frame_{ 0 };
+};
+
+}  // namespace chip8
@@ -2,85 +2,537 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
-#include <cstdlib>
+#include <cstring>
 #include <exception>
-#include <fstream>
 #include <iomanip>
 #include <ios>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <random>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 #include "keyboard.h"
+#include "operations.h"
+#include "quirks.h"
+#include "rom_cache.h"
+#include "scheduler.h"
 #include "screen.h"
 #include "speaker.h"
 
 namespace chip8 {
 
-Emulator::Emulator(const std::string& filename, Screen& screen, Speaker& speaker,
-                   std::chrono::microseconds delay)
-    : screen_{ screen }, speaker_(speaker), delay_{ delay } {
-  std::srand(std::time(nullptr));
-  ClearScreen();
-  LoadFontSet();
+namespace {
+
+// Every instruction the core implements paired with the call that executes it, written against `self` (the
+// emulator) and `instr` (the decoded instruction). The opcode table and the table and computed-goto
+// dispatchers are all generated from this list so they cannot drift apart.
+#define CHIP8_OPERATIONS(OPERATION)                                                                   \
+  OPERATION(kIgnore, static_cast<void>(self))                                                          \
+  OPERATION(kClearScreen, self.ClearScreen())                                                          \
+  OPERATION(kReturnFromSubroutine, self.ReturnFromSubroutine())                                        \
+  OPERATION(kScrollDown, self.ScrollDown(instr.fourth_nibble))                                         \
+  OPERATION(kScrollRight, self.ScrollRight())                                                          \
+  OPERATION(kScrollLeft, self.ScrollLeft())                                                            \
+  OPERATION(kLowResolution, self.SetResolution(false))                                                 \
+  OPERATION(kHighResolution, self.SetResolution(true))                                                 \
+  OPERATION(kJump, self.Jump(instr.raw & 0x0FFF))                                                      \
+  OPERATION(kCallSubroutine, self.CallSubroutine(instr.raw & 0x0FFF))                                  \
+  OPERATION(kSkipInstructionIfVxEqual,                                                                 \
+            self.SkipInstructionIfVxEqual(instr.second_nibble, instr.raw & 0x00FF))                    \
+  OPERATION(kSkipInstructionIfVxNotEqual,                                                              \
+            self.SkipInstructionIfVxNotEqual(instr.second_nibble, instr.raw & 0x00FF))                 \
+  OPERATION(kSkipInstructionIfVxEqualVy,                                                               \
+            self.SkipInstructionIfVxEqualVy(instr.second_nibble, instr.third_nibble))                  \
+  OPERATION(kSetRegisterVx, self.SetRegisterVx(instr.second_nibble, instr.raw & 0x00FF))               \
+  OPERATION(kAddToRegisterVx, self.AddToRegisterVx(instr.second_nibble, instr.raw & 0x00FF))           \
+  OPERATION(kSetVy2Vx, self.SetVy2Vx(instr.second_nibble, instr.third_nibble))                         \
+  OPERATION(kVxBinaryOrVy, self.VxBinaryOrVy(instr.second_nibble, instr.third_nibble))                 \
+  OPERATION(kVxBinaryAndVy, self.VxBinaryAndVy(instr.second_nibble, instr.third_nibble))               \
+  OPERATION(kVxBinaryXorVy, self.VxBinaryXorVy(instr.second_nibble, instr.third_nibble))               \
+  OPERATION(kAddVy2Vx, self.AddVy2Vx(instr.second_nibble, instr.third_nibble))                         \
+  OPERATION(kVxSubtractVy, self.VxSubtractVy(instr.second_nibble, instr.third_nibble))                 \
+  OPERATION(kShiftVxRight, self.ShiftVxRight(instr.second_nibble, instr.third_nibble))               \
+  OPERATION(kVySubtractVx, self.VySubtractVx(instr.second_nibble, instr.third_nibble))                 \
+  OPERATION(kShiftVxLeft, self.ShiftVxLeft(instr.second_nibble, instr.third_nibble))                 \
+  OPERATION(kSkipInstructionIfVxNotEqualVy,                                                            \
+            self.SkipInstructionIfVxNotEqualVy(instr.second_nibble, instr.third_nibble))               \
+  OPERATION(kSetIndexRegister, self.SetIndexRegister(instr.raw & 0x0FFF))                              \
+  OPERATION(kJumpWithOffset, self.JumpWithOffset(instr.raw & 0x0FFF))                                  \
+  OPERATION(kVxBinaryAndRandom, self.VxBinaryAndRandom(instr.second_nibble, instr.raw & 0x00FF))       \
+  OPERATION(kDisplay, self.Display(instr.second_nibble, instr.third_nibble, instr.fourth_nibble))      \
+  OPERATION(kSkipInstructionIfPressed, self.SkipInstructionIfPressed(instr.second_nibble))             \
+  OPERATION(kSkipInstructionIfNotPressed, self.SkipInstructionIfNotPressed(instr.second_nibble))       \
+  OPERATION(kAddVx2IndexRegister, self.AddVx2IndexRegister(instr.second_nibble))                       \
+  OPERATION(kWaitForKeyPress, self.WaitForKeyPress(instr.second_nibble))                               \
+  OPERATION(kSetIndexRegisterForFont, self.SetIndexRegisterForFont(instr.second_nibble))               \
+  OPERATION(kHexInVxToDecimal, self.HexInVxToDecimal(instr.second_nibble))                             \
+  OPERATION(kStoreRegistersInMemory, self.StoreRegistersInMemory(instr.second_nibble))                 \
+  OPERATION(kLoadRegistersFromMemory, self.LoadRegistersFromMemory(instr.second_nibble))               \
+  OPERATION(kSetDelayTimer2Vx, self.SetDelayTimer2Vx(instr.second_nibble))                             \
+  OPERATION(kSetDelayTimer, self.SetDelayTimer(instr.second_nibble))                                   \
+  OPERATION(kSetSoundTimer, self.SetSoundTimer(instr.second_nibble))                                   \
+  OPERATION(kUnknown, throw std::invalid_argument{ "unknown opcode" })
+
+// Catches CHIP8_OPERATIONS, the Operation enum and kOperationNames disagreeing on order.
+constexpr bool OperationsMatchEnum() {
+  constexpr std::array kListed{
+#define CHIP8_OPERATION_ENUMERATOR(name, call) Operation::name,
+    CHIP8_OPERATIONS(CHIP8_OPERATION_ENUMERATOR)
+#undef CHIP8_OPERATION_ENUMERATOR
+  };
+  constexpr std::array<std::string_view, kListed.size()> kListedNames{
+#define CHIP8_OPERATION_NAME(name, call) std::string_view{ #name }.substr(1),
+    CHIP8_OPERATIONS(CHIP8_OPERATION_NAME)
+#undef CHIP8_OPERATION_NAME
+  };
+  for (size_t i = 0; i < kListed.size(); ++i) {
+    if (static_cast<size_t>(kListed[i]) != i || kListedNames[i] != kOperationNames[i]) return false;
+  }
+  return kListed.size() == static_cast<size_t>(Operation::kUnknown) + 1;
+}
+static_assert(OperationsMatchEnum());
+
+// Seed of an instance that is not seeded explicitly. Reading std::random_device takes system calls that cost
+// more than the whole rest of constructing an instance, so it is only read once per process and instances
+// take consecutive seeds after it, which Random::Seed expands into unrelated sequences.
+uint64_t NextEntropySeed() {
+  static const uint64_t base{ [] {
+    std::random_device entropy;
+    return (static_cast<uint64_t>(entropy()) << 32) | entropy();
+  }() };
+  static std::atomic<uint64_t> next{ 0 };
+  return base + next.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Bytes [kFirst, kLast) of a SaveState filled in field by field, so neighbouring fields reach a RewindBuffer
+// as one update of whole words. Fields left unset are zero.
+template <size_t kFirst, size_t kLast>
+class SaveStateBlock {
+  static_assert(kFirst % sizeof(uint64_t) == 0 && kLast % sizeof(uint64_t) == 0);
+
+ public:
+  static inline const size_t kOffset{ kFirst };
+
+  template <typename T>
+  void Set(size_t offset, const T& value) {
+    std::memcpy(bytes_.data() + offset - kFirst, &value, sizeof(T));
+  }
+
+  std::span<const uint8_t> Bytes() const { return bytes_; }
+
+ private:
+  std::array<uint8_t, kLast - kFirst> bytes_{};
+};
+
+}  // namespace
+
+template <Quirks kQuirks>
+BasicEmulator<kQuirks>::BasicEmulator(const std::string& filename, Screen& screen, Speaker& speaker,
+                                      Keyboard& keyboard, uint32_t clock_speed, Mode mode, Engine engine)
+    : clock_speed_{ clock_speed },
+      mode_{ mode },
+      engine_{ engine },
+      screen_{ screen },
+      speaker_{ speaker },
+      keyboard_{ keyboard } {
+  if (clock_speed_ == 0) {
+    throw std::invalid_argument{ "clock speed must be positive" };
+  }
+  // Loaded first so a rejected ROM fails before any of the caches below are allocated.
   LoadProgramText(filename);
+  next_timer_tick_cycle_ = NextTimerTickCycle();
+
+  random_.Seed(NextEntropySeed());
+  ClearScreen();
+
+  if (engine_ == Engine::kPredecoded || engine_ == Engine::kBlocks) {
+    predecoded_.resize(kChip8MemorySize / 2);
+  }
+  if (engine_ == Engine::kBlocks) {
+    block_lengths_.resize(kChip8MemorySize / 2);
+  }
+};
+
+template <Quirks kQuirks>
+BasicEmulator<kQuirks>::BasicEmulator(const BasicEmulator& parent, Screen& screen, Speaker& speaker,
+                                      Keyboard& keyboard)
+    : variable_registers_{ parent.variable_registers_ },
+      stack_{ parent.stack_ },
+      stack_pointer_{ parent.stack_pointer_ },
+      memory_{ parent.memory_ },
+      program_counter_{ parent.program_counter_ },
+      screen_matrix_{ parent.screen_matrix_ },
+      index_register_{ parent.index_register_ },
+      delay_timer_{ parent.delay_timer_ },
+      sound_timer_{ parent.sound_timer_ },
+      screen_dirty_{ true },
+      cycles_{ parent.cycles_ },
+      timer_ticks_{ parent.timer_ticks_ },
+      next_timer_tick_cycle_{ parent.next_timer_tick_cycle_ },
+      random_{ parent.random_ },
+      key_wait_register_{ parent.key_wait_register_ },
+      predecoded_{ parent.predecoded_ },
+      block_lengths_{ parent.block_lengths_ },
+      clock_speed_{ parent.clock_speed_ },
+      mode_{ parent.mode_ },
+      engine_{ parent.engine_ },
+      screen_{ screen },
+      speaker_{ speaker },
+      keyboard_{ keyboard } {
+  if (sound_timer_ > 0) {
+    speaker_.Beep(sound_timer_);
+  }
 };
 
-void Emulator::StartExecutionLoop() {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::StartExecutionLoop() {
+  FrameScheduler scheduler{ kChip8TimerFrequency };
   while (screen_.IsOpen()) {
-    const auto raw{ Fetch() };
-    if (!raw.has_value()) {
-      return;
+    RunFrame();
+    if (telemetry_ != nullptr) {
+      telemetry_->RecordFrame(cycles_);
+    }
+    if (mode_ == Mode::kRealtime) {
+      const auto overshoot{ scheduler.WaitForNextFrame() };
+      if (telemetry_ != nullptr) {
+        telemetry_->RecordOvershoot(overshoot);
+      }
+    }
+  }
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::Step() {
+  if (key_wait_register_.has_value()) {
+    CHIP8_PROFILE_HOOK(++profile_.key_wait_cycles);
+    ResolveKeyWait();
+  } else {
+    switch (engine_) {
+      case Engine::kInterpreter:
+        Interpret();
+        break;
+      case Engine::kPredecoded:
+      case Engine::kBlocks:
+        ExecutePredecoded();
+        break;
+    }
+  }
+  ++cycles_;
+
+  OnTimersTick();
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::Interpret() {
+  CHIP8_PROFILE_HOOK(const uint16_t address{ static_cast<uint16_t>(program_counter_) });
+  const auto raw{ Fetch() };
+  if (!raw.has_value()) {
+    return;
+  }
+
+  Instruction instr{ Decode(*raw) };
+  CHIP8_PROFILE_HOOK(profile_.CountInstruction(address, kOperationTable[instr.raw]));
+
+  Execute(instr);
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ExecutePredecoded() {
+  // Instructions at odd addresses or straddling the end of memory are rare enough to not be worth caching.
+  if ((program_counter_ & 1) != 0 || program_counter_ >= kChip8MemorySize - 1) {
+    Interpret();
+    return;
+  }
+
+  const DecodedInstruction& entry{ PredecodedAt(program_counter_ >> 1) };
+  CHIP8_PROFILE_HOOK(profile_.CountInstruction(program_counter_, static_cast<Operation>(entry.operation)));
+  program_counter_ += 2;
+
+  ExecuteOperation(entry.operation, entry.instr);
+};
+
+template <Quirks kQuirks>
+typename BasicEmulator<kQuirks>::DecodedInstruction& BasicEmulator<kQuirks>::PredecodedAt(size_t index) {
+  DecodedInstruction& entry{ predecoded_[index] };
+  if (!entry.valid) {
+    const Instruction instr{ Decode({ memory_[index * 2], memory_[index * 2 + 1] }) };
+    entry = { .instr = instr, .operation = static_cast<uint8_t>(kOperationTable[instr.raw]), .valid = true };
+  }
+  return entry;
+};
+
+template <Quirks kQuirks>
+uint64_t BasicEmulator<kQuirks>::ExecuteBlock(uint64_t budget) {
+  if ((program_counter_ & 1) != 0 || program_counter_ >= kChip8MemorySize - 1) {
+    Interpret();
+    return 1;
+  }
+
+  const size_t start{ static_cast<size_t>(program_counter_) >> 1 };
+  if (block_lengths_[start] == 0) {
+    block_lengths_[start] = TranslateBlock(start);
+  }
+
+  // Only the last instruction of a block can branch or write memory, so the rest run back to back.
+  const size_t end{ start + std::min<uint64_t>(block_lengths_[start], budget) };
+  for (size_t i = start; i < end; ++i) {
+    CHIP8_PROFILE_HOOK(
+        profile_.CountInstruction(program_counter_, static_cast<Operation>(predecoded_[i].operation)));
+    program_counter_ += 2;
+    ExecuteOperation(predecoded_[i].operation, predecoded_[i].instr);
+  }
+  return end - start;
+};
+
+template <Quirks kQuirks>
+uint8_t BasicEmulator<kQuirks>::TranslateBlock(size_t start) {
+  uint8_t length{ 0 };
+  for (size_t i = start; i < predecoded_.size() && length < kMaxBlockLength; ++i) {
+    ++length;
+    if (EndsBasicBlock(static_cast<Operation>(PredecodedAt(i).operation))) break;
+  }
+  return length;
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::WriteMemory(uint16_t address, uint8_t value) {
+  address &= kChip8MemorySize - 1;
+  CHIP8_PROFILE_HOOK(profile_.CountWrite(address));
+  memory_.Write(address, value);
+  rewind_pages_ |= static_cast<uint16_t>(1 << (address / PagedMemory::kPageSize));
+  if (!predecoded_.empty()) {
+    predecoded_[address >> 1].valid = false;
+  }
+
+  // Drop every block that covers the written instruction, i.e. those starting at most kMaxBlockLength - 1
+  // instructions before it and long enough to reach it.
+  if (!block_lengths_.empty()) {
+    const size_t entry{ static_cast<size_t>(address) >> 1 };
+    const size_t first{ entry >= kMaxBlockLength - 1 ? entry - (kMaxBlockLength - 1) : 0 };
+    for (size_t start = first; start <= entry; ++start) {
+      if (start + block_lengths_[start] > entry) block_lengths_[start] = 0;
     }
+  }
+};
 
-    Instruction instr{ Decode(*raw) };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::RunFrame() {
+  const uint64_t frame{ timer_ticks_ };
+  while (timer_ticks_ == frame) {
+    if (key_wait_register_.has_value()) {
+      // Every cycle spent waiting tests the same latched keypad, so once no key is held the rest of the frame
+      // is idle and the instance parks until the timers tick.
+      CHIP8_PROFILE_HOOK(const uint64_t wait_start{ cycles_ });
+      cycles_ = ResolveKeyWait() ? cycles_ + 1 : next_timer_tick_cycle_;
+      CHIP8_PROFILE_HOOK(profile_.key_wait_cycles += cycles_ - wait_start);
+      OnTimersTick();
+    } else if (engine_ == Engine::kBlocks) {
+      // A block never runs past the next timers tick, so timers observe the same cycle counts as with the
+      // other engines.
+      cycles_ += ExecuteBlock(next_timer_tick_cycle_ - cycles_);
+      OnTimersTick();
+    } else {
+      Step();
+    }
+  }
+  Present();
+
+  if (rewind_ != nullptr) {
+    RecordRewindFrame();
+  }
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::RecordRewindFrame() {
+  if (rewind_->IsEmpty()) {
+    rewind_->Record(Snapshot());
+    rewind_pages_ = 0;
+    rewind_drawn_ = false;
+    rewind_hires_ = screen_matrix_.hires;
+    return;
+  }
+
+  // Only what a frame can have changed goes to the buffer: the registers, the visible framebuffer rows if
+  // anything was drawn, and the pages written to. The buffer keeps just the words that differ.
+  SaveStateBlock<offsetof(SaveState, magic), offsetof(SaveState, framebuffer_left)> timing;
+  timing.Set(offsetof(SaveState, magic), SaveState::kMagic);
+  timing.Set(offsetof(SaveState, version), SaveState::kVersion);
+  timing.Set(offsetof(SaveState, hires), static_cast<uint8_t>(screen_matrix_.hires));
+  timing.Set(offsetof(SaveState, cycles), cycles_);
+  timing.Set(offsetof(SaveState, timer_ticks), timer_ticks_);
+  timing.Set(offsetof(SaveState, random_state), random_.GetState());
+  SaveStateBlock<offsetof(SaveState, stack), offsetof(SaveState, memory)> registers;
+  registers.Set(offsetof(SaveState, stack), stack_);
+  registers.Set(offsetof(SaveState, program_counter), static_cast<uint16_t>(program_counter_));
+  registers.Set(offsetof(SaveState, index_register), index_register_);
+  registers.Set(offsetof(SaveState, variable_registers), variable_registers_);
+  registers.Set(offsetof(SaveState, stack_pointer), stack_pointer_);
+  registers.Set(offsetof(SaveState, delay_timer), delay_timer_);
+  registers.Set(offsetof(SaveState, sound_timer), sound_timer_);
+  if (key_wait_register_.has_value()) {
+    registers.Set(offsetof(SaveState, key_wait),
+                  static_cast<uint8_t>(SaveState::kKeyWaitFlag | *key_wait_register_));
+  }
+
+  rewind_->BeginFrame();
+  rewind_->Update(timing.kOffset, timing.Bytes());
+  if (rewind_drawn_) {
+    // Rows past the bottom of a low resolution frame are zero, and were so in the last one recorded unless
+    // it was at high resolution.
+    const bool hires{ screen_matrix_.hires || rewind_hires_ };
+    const size_t rows{ hires ? kFramebufferHeight : kLowResFramebufferHeight };
+    const std::span<const uint8_t> left{ reinterpret_cast<const uint8_t*>(screen_matrix_.left.data()),
+                                         rows * sizeof(uint64_t) };
+    rewind_->Update(offsetof(SaveState, framebuffer_left), left);
+    if (hires) {
+      rewind_->Update(offsetof(SaveState, framebuffer_right), screen_matrix_.right);
+    }
+  }
+  rewind_->Update(registers.kOffset, registers.Bytes());
+  for (size_t page = 0; page < PagedMemory::kPageCount; ++page) {
+    if (((rewind_pages_ >> page) & 1) == 0) continue;
+    rewind_->Update(offsetof(SaveState, memory) + page * PagedMemory::kPageSize, memory_.GetPage(page));
+  }
+  rewind_->EndFrame();
+  rewind_pages_ = 0;
+  rewind_drawn_ = false;
+  rewind_hires_ = screen_matrix_.hires;
+};
 
-    Execute(instr);
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::Present() {
+  if (!screen_dirty_) return;
 
-    OnTimersTick();
+  screen_.Draw(screen_matrix_);
+  screen_dirty_ = false;
+  rewind_drawn_ = true;
+  if (telemetry_ != nullptr) {
+    telemetry_->RecordPublish();
   }
+  CHIP8_PROFILE_HOOK(++profile_.presents);
+};
+
+template <Quirks kQuirks>
+MachineState BasicEmulator<kQuirks>::CaptureState() const {
+  return {
+    .variable_registers = variable_registers_,
+    .stack = stack_,
+    .stack_pointer = stack_pointer_,
+    .program_counter = static_cast<uint16_t>(program_counter_),
+    .index_register = index_register_,
+    .delay_timer = delay_timer_,
+    .sound_timer = sound_timer_,
+    .memory = memory_.Contents(),
+    .framebuffer = screen_matrix_,
+    .random_state = random_.GetState(),
+    .key_wait_register = key_wait_register_,
+  };
 };
 
-void Emulator::LoadProgramText(const std::string& filename) {
-  std::ifstream rom_file{ filename, std::ios::in | std::ios::binary | std::ios::ate };
-  if (!rom_file) {
-    throw std::invalid_argument{ "failed to open rom file" };
+template <Quirks kQuirks>
+SaveState BasicEmulator<kQuirks>::Snapshot() const {
+  SaveState state;
+  state.cycles = cycles_;
+  state.timer_ticks = timer_ticks_;
+  state.random_state = random_.GetState();
+  state.hires = screen_matrix_.hires;
+  state.framebuffer_left = screen_matrix_.left;
+  state.framebuffer_right = screen_matrix_.right;
+  state.stack = stack_;
+  state.program_counter = static_cast<uint16_t>(program_counter_);
+  state.index_register = index_register_;
+  state.variable_registers = variable_registers_;
+  state.stack_pointer = stack_pointer_;
+  state.delay_timer = delay_timer_;
+  state.sound_timer = sound_timer_;
+  if (key_wait_register_.has_value()) {
+    state.key_wait = static_cast<uint8_t>(SaveState::kKeyWaitFlag | *key_wait_register_);
   }
-  rom_file.unsetf(std::ios::skipws);
+  state.memory = memory_.Contents();
+  return state;
+};
 
-  int64_t file_size{ rom_file.tellg() };
-  if (file_size > kChip8MemorySize) {
-    throw std::invalid_argument{ "rom file is too large to fit into chip8 memory" };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::Restore(const SaveState& state) {
+  if (state.magic != SaveState::kMagic || state.version != SaveState::kVersion) {
+    throw std::invalid_argument{ "unsupported save state format" };
+  }
+  // Any program counter and stack pointer is fine: fetches wrap around the end of memory, and the stack
+  // wraps around its 16 entries.
+  if ((state.key_wait & ~(SaveState::kKeyWaitFlag | 0xF)) != 0 || state.hires > 1 ||
+      (state.hires && !kQuirks.extended_display)) {
+    throw std::invalid_argument{ "save state is out of range" };
   }
 
-  rom_file.seekg(0, std::ios::beg);
+  cycles_ = state.cycles;
+  timer_ticks_ = state.timer_ticks;
+  next_timer_tick_cycle_ = NextTimerTickCycle();
+  random_.SetState(state.random_state);
+  screen_matrix_.hires = state.hires;
+  screen_matrix_.left = state.framebuffer_left;
+  screen_matrix_.right = state.framebuffer_right;
+  screen_dirty_ = true;
+  stack_ = state.stack;
+  program_counter_ = state.program_counter;
+  index_register_ = state.index_register;
+  variable_registers_ = state.variable_registers;
+  stack_pointer_ = state.stack_pointer;
+  delay_timer_ = state.delay_timer;
+  sound_timer_ = state.sound_timer;
+  speaker_.Beep(sound_timer_);
+  key_wait_register_.reset();
+  if (state.key_wait & SaveState::kKeyWaitFlag) {
+    key_wait_register_ = state.key_wait & 0xF;
+  }
+  memory_.Assign(state.memory);
+  rewind_pages_ = kAllPages;
+  keypad_frame_.reset();
 
-  rom_file.read(reinterpret_cast<char*>(memory_.data() + kChip8ProgramStartAddress), file_size);
-  if (!rom_file.good()) {
-    throw std::runtime_error{ "Error reading file" };
+  for (DecodedInstruction& entry : predecoded_) {
+    entry.valid = false;
   }
+  std::fill(block_lengths_.begin(), block_lengths_.end(), 0);
 };
 
-void Emulator::LoadFontSet() {
-  for (size_t i = 0; i < kChip8FontSet.size(); i++) {
-    memory_[i] = kChip8FontSet[i];
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::AttachRewindBuffer(RewindBuffer* buffer) {
+  rewind_ = buffer;
+  if (rewind_ != nullptr) {
+    rewind_->Record(Snapshot());
+    rewind_pages_ = 0;
+    rewind_drawn_ = false;
+    rewind_hires_ = screen_matrix_.hires;
   }
 };
 
-std::optional<std::array<uint8_t, 2>> Emulator::Fetch() {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::LoadProgramText(const std::string& filename) {
+  // The cached image already holds the font set, and its pages stay shared until this instance writes to
+  // them, so loading costs a handful of reference count increments.
+  memory_ = RomCache::Instance().Load(filename)->Memory();
+};
+
+template <Quirks kQuirks>
+std::optional<std::array<uint8_t, 2>> BasicEmulator<kQuirks>::Fetch() {
   uint8_t first{ memory_[program_counter_++] };
   uint8_t sec{ memory_[program_counter_++] };
   return std::array{ first, sec };
 };
 
-Emulator::Instruction Emulator::Decode(std::array<uint8_t, 2> instr) {
+EmulatorBase::Instruction EmulatorBase::Decode(std::array<uint8_t, 2> instr) {
   uint8_t high_byte = instr[0];
   uint8_t low_byte = instr[1];
 
@@ -93,7 +545,35 @@ Emulator::Instruction Emulator::Decode(std::array<uint8_t, 2> instr) {
   };
 };
 
-void Emulator::Execute(const Instruction& instr) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ExecuteOpcode(uint16_t raw) {
+  program_counter_ = (program_counter_ + 2) & (kChip8MemorySize - 1);
+  Execute(Decode({ static_cast<uint8_t>(raw >> 8), static_cast<uint8_t>(raw & 0xFF) }));
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::Execute(const Instruction& instr) {
+#if defined(CHIP8_DISPATCH_TABLE)
+  ExecuteOperation(static_cast<uint8_t>(kOperationTable[instr.raw]), instr);
+
+#elif defined(CHIP8_DISPATCH_GOTO)
+  static void* const kLabels[] = {
+#define CHIP8_OPERATION_LABEL_ADDRESS(name, call) &&name,
+    CHIP8_OPERATIONS(CHIP8_OPERATION_LABEL_ADDRESS)
+#undef CHIP8_OPERATION_LABEL_ADDRESS
+  };
+
+  BasicEmulator& self{ *this };
+  goto* kLabels[static_cast<size_t>(kOperationTable[instr.raw])];
+
+#define CHIP8_OPERATION_LABEL(name, call) \
+  name:                                   \
+  call;                                   \
+  return;
+  CHIP8_OPERATIONS(CHIP8_OPERATION_LABEL)
+#undef CHIP8_OPERATION_LABEL
+
+#else
   switch (instr.first_nibble) {
     case 0x0:
       switch (instr.third_nibble) {
@@ -110,6 +590,30 @@ void Emulator::Execute(const Instruction& instr) {
             default:
               throw std::invalid_argument{ "unknown opcode" };
           }
+
+        case 0xC:
+          if (instr.second_nibble == 0x0) ScrollDown(instr.fourth_nibble);
+          return;
+
+        case 0xF:
+          if (instr.second_nibble != 0x0) return;
+          switch (instr.fourth_nibble) {
+            case 0xB:
+              ScrollRight();
+              return;
+
+            case 0xC:
+              ScrollLeft();
+              return;
+
+            case 0xE:
+              SetResolution(false);
+              return;
+
+            case 0xF:
+              SetResolution(true);
+              return;
+          }
       }
       return;
 
@@ -162,13 +666,13 @@ void Emulator::Execute(const Instruction& instr) {
           VxSubtractVy(instr.second_nibble, instr.third_nibble);
           return;
         case 0x6:
-          ShiftVxRight(instr.second_nibble);
+          ShiftVxRight(instr.second_nibble, instr.third_nibble);
           return;
         case 0x7:
           VySubtractVx(instr.second_nibble, instr.third_nibble);
           return;
         case 0xE:
-          ShiftVxLeft(instr.second_nibble);
+          ShiftVxLeft(instr.second_nibble, instr.third_nibble);
           return;
         default:
           throw std::invalid_argument{ "unknown opcode" };
@@ -244,119 +748,275 @@ void Emulator::Execute(const Instruction& instr) {
     default:
       throw std::invalid_argument{ "unknown opcode" };
   }
+#endif
 };
 
-void Emulator::OnTimersTick() {
-  if (delay_timer_ > 0) --delay_timer_;
-  if (sound_timer_ > 0) --sound_timer_;
-  if (sound_timer_ > 0) {
-    speaker_.Play();
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ExecuteOperation(uint8_t operation, const Instruction& instr) {
+  using Handler = void (*)(BasicEmulator&, const Instruction&);
+  static constexpr std::array<Handler, static_cast<size_t>(Operation::kUnknown) + 1> kHandlers{
+#define CHIP8_OPERATION_HANDLER(name, call) \
+  []([[maybe_unused]] BasicEmulator& self, [[maybe_unused]] const Instruction& instr) { call; },
+    CHIP8_OPERATIONS(CHIP8_OPERATION_HANDLER)
+#undef CHIP8_OPERATION_HANDLER
+  };
+
+  kHandlers[operation](*this, instr);
+};
+
+template <Quirks kQuirks>
+bool BasicEmulator<kQuirks>::ResolveKeyWait() {
+  const uint16_t keys{ Keypad() };
+  if (keys == 0) return false;
+
+  variable_registers_[*key_wait_register_] = static_cast<uint8_t>(std::countr_zero(keys));
+  key_wait_register_.reset();
+  return true;
+};
+
+template <Quirks kQuirks>
+uint16_t BasicEmulator<kQuirks>::Keypad() {
+  if (keypad_frame_ != timer_ticks_) {
+    const uint16_t keys{ keyboard_.LatchKeys(timer_ticks_) };
+    if (telemetry_ != nullptr && keys != keypad_) {
+      telemetry_->RecordInput();
+    }
+    keypad_ = keys;
+    keypad_frame_ = timer_ticks_;
+  }
+  return keypad_;
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::OnTimersTick() {
+  while (cycles_ >= next_timer_tick_cycle_) {
+    ++timer_ticks_;
+    next_timer_tick_cycle_ = NextTimerTickCycle();
+    CHIP8_PROFILE_HOOK(profile_.CountTimerTick(delay_timer_, sound_timer_));
+
+    if (delay_timer_ > 0) --delay_timer_;
+    if (sound_timer_ > 0) --sound_timer_;
   }
-  std::this_thread::sleep_for(std::chrono::microseconds{ delay_ });
 };
 
-void Emulator::ClearScreen() {
-  for (int y = 0; y < kChip8ScreenHeight; ++y) {
-    for (int x = 0; x < kChip8ScreenWidth; ++x) {
-      screen_matrix_[y][x] = 0;
+template <Quirks kQuirks>
+uint64_t BasicEmulator<kQuirks>::NextTimerTickCycle() const {
+  // First cycle at which (timer_ticks_ + 1) periods of the virtual 60 Hz clock have elapsed.
+  return ((timer_ticks_ + 1) * clock_speed_ + kChip8TimerFrequency - 1) / kChip8TimerFrequency;
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ClearScreen() {
+  screen_matrix_.left.fill(0);
+  screen_matrix_.right.fill(0);
+  screen_dirty_ = true;
+};
+
+// Scrolling moves the whole screen every time it runs, which programs do up to every frame at high
+// resolution. Each one is a straight loop over the rows of a framebuffer half, so it compiles to a memmove
+// or to vector shifts, and distances are in pixels of the current resolution, as on XO-CHIP.
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ScrollDown(uint8_t n) {
+  if constexpr (kQuirks.extended_display) {
+    const size_t height{ screen_matrix_.Height() };
+    for (auto* half : { &screen_matrix_.left, &screen_matrix_.right }) {
+      std::copy_backward(half->begin(), half->begin() + (height - n), half->begin() + height);
+      std::fill(half->begin(), half->begin() + n, 0);
     }
+    screen_dirty_ = true;
+  }
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ScrollRight() {
+  if constexpr (kQuirks.extended_display) {
+    auto& left{ screen_matrix_.left };
+    auto& right{ screen_matrix_.right };
+    if (screen_matrix_.hires) {
+      for (size_t y = 0; y < kFramebufferHeight; ++y) {
+        right[y] = (right[y] >> 4) | (left[y] << 60);
+        left[y] >>= 4;
+      }
+    } else {
+      for (size_t y = 0; y < kLowResFramebufferHeight; ++y) {
+        left[y] >>= 4;
+      }
+    }
+    screen_dirty_ = true;
   }
-  screen_.Draw(screen_matrix_);
 };
 
-void Emulator::Jump(uint16_t address) { program_counter_ = address; };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ScrollLeft() {
+  if constexpr (kQuirks.extended_display) {
+    auto& left{ screen_matrix_.left };
+    auto& right{ screen_matrix_.right };
+    if (screen_matrix_.hires) {
+      for (size_t y = 0; y < kFramebufferHeight; ++y) {
+        left[y] = (left[y] << 4) | (right[y] >> 60);
+        right[y] <<= 4;
+      }
+    } else {
+      for (size_t y = 0; y < kLowResFramebufferHeight; ++y) {
+        left[y] <<= 4;
+      }
+    }
+    screen_dirty_ = true;
+  }
+};
+
+// Switching resolution clears the screen, so whatever is left over never has to be scaled to the new one.
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetResolution(bool hires) {
+  if constexpr (kQuirks.extended_display) {
+    screen_matrix_.hires = hires;
+    ClearScreen();
+  }
+};
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::Jump(uint16_t address) { program_counter_ = address; };
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetRegisterVx(uint8_t x, uint8_t value) { variable_registers_[x] = value; };
 
-void Emulator::SetRegisterVx(uint8_t x, uint8_t value) { variable_registers_[x] = value; };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::AddToRegisterVx(uint8_t x, uint8_t value) { variable_registers_[x] += value; };
 
-void Emulator::AddToRegisterVx(uint8_t x, uint8_t value) { variable_registers_[x] += value; };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetIndexRegister(uint16_t value) { index_register_ = value; };
 
-void Emulator::SetIndexRegister(uint16_t value) { index_register_ = value; };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::Display(uint8_t x, uint8_t y, uint8_t n) {
+  const size_t width{ screen_matrix_.Width() };
+  const size_t height{ screen_matrix_.Height() };
+  // Both resolutions are powers of two.
+  const size_t start_from_y{ variable_registers_[y] & (height - 1) };
+  const size_t start_from_x{ variable_registers_[x] & (width - 1) };
 
-void Emulator::Display(uint8_t x, uint8_t y, uint8_t n) {
-  uint8_t start_from_y = variable_registers_[y] % kChip8ScreenHeight;
-  uint8_t start_from_x = variable_registers_[x] % kChip8ScreenWidth;
+  // DXY0 draws a 16x16 sprite stored as two bytes per row.
+  const bool wide{ kQuirks.extended_display && n == 0 };
+  const size_t rows{ wide ? 16u : n };
+  const size_t sprite_width{ wide ? 16u : 8u };
 
-  variable_registers_[0xF] = 0;
+  bool collision{ false };
 
-  for (size_t y = 0; y < n; ++y) {
+  for (size_t y = 0; y < rows; ++y) {
     size_t target_y{ start_from_y + y };
-    if (target_y >= kChip8ScreenHeight) {
+    if constexpr (kQuirks.sprites_wrap) {
+      target_y &= height - 1;
+    } else if (target_y >= height) {
       break;
     }
 
-    uint8_t pixel = memory_[index_register_ + y];
-
-    for (size_t x = 0; x < 8; ++x) {
-      size_t target_x{ start_from_x + x };
-      if (target_x >= kChip8ScreenWidth) {
-        break;
-      }
-
-      if ((pixel & (0x80 >> x)) != 0) {  // sprite bit is set
-        uint8_t& location{ screen_matrix_[target_y][target_x] };
-        if (location != 0) {  // screen bit is set
-          variable_registers_[0xF] = 1;
-        }
-        location ^= 1;
+    // Align the sprite row with the leftmost pixel and move it into place.
+    const uint64_t bits{ wide ? static_cast<uint64_t>(memory_[index_register_ + 2 * y] << 8 |
+                                                      memory_[index_register_ + 2 * y + 1])
+                              : memory_[index_register_ + y] };
+    const uint64_t aligned{ bits << (64 - sprite_width) };
+    uint64_t& left{ screen_matrix_.left[target_y] };
+    if (!screen_matrix_.hires) {
+      // A row is exactly one word, so rotating wraps bits pushed past the right edge around to the left,
+      // while shifting drops them, which clips the sprite.
+      const uint64_t sprite{ kQuirks.sprites_wrap ? std::rotr(aligned, static_cast<int>(start_from_x))
+                                                  : aligned >> start_from_x };
+      collision |= (left & sprite) != 0;
+      left ^= sprite;
+    } else {
+      // The same over a row of two words: a sprite starting in the left word spills into the right one, and
+      // one starting in the right word spills past the edge, wrapping to the left word or being dropped.
+      uint64_t& right{ screen_matrix_.right[target_y] };
+      uint64_t left_sprite{ 0 };
+      uint64_t right_sprite{ 0 };
+      if (start_from_x < 64) {
+        left_sprite = aligned >> start_from_x;
+        right_sprite = start_from_x == 0 ? 0 : aligned << (64 - start_from_x);
+      } else {
+        right_sprite = aligned >> (start_from_x - 64);
+        left_sprite = kQuirks.sprites_wrap && start_from_x > 64 ? aligned << (128 - start_from_x) : 0;
       }
+      collision |= ((left & left_sprite) | (right & right_sprite)) != 0;
+      left ^= left_sprite;
+      right ^= right_sprite;
     }
+    CHIP8_PROFILE_HOOK(++profile_.sprite_rows);
   }
 
-  screen_.Draw(screen_matrix_);
+  variable_registers_[0xF] = collision;
+  CHIP8_PROFILE_HOOK(profile_.collisions += collision);
+  screen_dirty_ = true;
 };
 
-void Emulator::CallSubroutine(uint16_t address) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::CallSubroutine(uint16_t address) {
   ++stack_pointer_;
-  stack_[stack_pointer_] = program_counter_;
+  stack_[stack_pointer_ & 0xF] = program_counter_;
   program_counter_ = address;
 }
 
-void Emulator::ReturnFromSubroutine() {
-  uint16_t addr{ stack_[stack_pointer_--] };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ReturnFromSubroutine() {
+  uint16_t addr{ stack_[stack_pointer_-- & 0xF] };
   program_counter_ = addr;
 }
 
-void Emulator::SkipInstructionIfVxEqual(uint8_t x, uint8_t value) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SkipInstructionIfVxEqual(uint8_t x, uint8_t value) {
   if (variable_registers_[x] == (value)) program_counter_ += 2;
 }
 
-void Emulator::SkipInstructionIfVxNotEqual(uint8_t x, uint8_t value) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SkipInstructionIfVxNotEqual(uint8_t x, uint8_t value) {
   if (variable_registers_[x] != (value)) program_counter_ += 2;
 }
 
-void Emulator::SkipInstructionIfVxEqualVy(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SkipInstructionIfVxEqualVy(uint8_t x, uint8_t y) {
   if (variable_registers_[x] == variable_registers_[y]) program_counter_ += 2;
 }
 
-void Emulator::SkipInstructionIfVxNotEqualVy(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SkipInstructionIfVxNotEqualVy(uint8_t x, uint8_t y) {
   if (variable_registers_[x] != variable_registers_[y]) program_counter_ += 2;
 }
 
-void Emulator::SkipInstructionIfPressed(uint8_t x) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SkipInstructionIfPressed(uint8_t x) {
   uint8_t key{ variable_registers_[x] };
-  if (Keyboard::IsKeyPressed(key)) program_counter_ += 2;
+  if ((Keypad() >> (key & 0xF)) & 1) program_counter_ += 2;
 }
 
-void Emulator::SkipInstructionIfNotPressed(uint8_t x) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SkipInstructionIfNotPressed(uint8_t x) {
   uint8_t key{ variable_registers_[x] };
-  if (!Keyboard::IsKeyPressed(key)) program_counter_ += 2;
+  if (!((Keypad() >> (key & 0xF)) & 1)) program_counter_ += 2;
 }
 
-void Emulator::SetVy2Vx(uint8_t x, uint8_t y) { variable_registers_[x] = variable_registers_[y]; }
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetVy2Vx(uint8_t x, uint8_t y) {
+  variable_registers_[x] = variable_registers_[y];
+}
 
-void Emulator::VxBinaryOrVy(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::VxBinaryOrVy(uint8_t x, uint8_t y) {
   variable_registers_[x] = variable_registers_[x] | variable_registers_[y];
+  if constexpr (kQuirks.logic_clears_vf) variable_registers_[0xF] = 0;
 }
 
-void Emulator::VxBinaryAndVy(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::VxBinaryAndVy(uint8_t x, uint8_t y) {
   variable_registers_[x] = variable_registers_[x] & variable_registers_[y];
+  if constexpr (kQuirks.logic_clears_vf) variable_registers_[0xF] = 0;
 }
 
-void Emulator::VxBinaryXorVy(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::VxBinaryXorVy(uint8_t x, uint8_t y) {
   variable_registers_[x] = variable_registers_[x] ^ variable_registers_[y];
+  if constexpr (kQuirks.logic_clears_vf) variable_registers_[0xF] = 0;
 }
 
-void Emulator::AddVy2Vx(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::AddVy2Vx(uint8_t x, uint8_t y) {
   int result{ variable_registers_[x] + variable_registers_[y] };
   if (result > 255)
     variable_registers_[0xF] = 1;
@@ -366,7 +1026,8 @@ void Emulator::AddVy2Vx(uint8_t x, uint8_t y) {
   variable_registers_[x] = result;
 }
 
-void Emulator::VxSubtractVy(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::VxSubtractVy(uint8_t x, uint8_t y) {
   if (variable_registers_[x] > variable_registers_[y])
     variable_registers_[0xF] = 1;
   else
@@ -374,7 +1035,8 @@ void Emulator::VxSubtractVy(uint8_t x, uint8_t y) {
   variable_registers_[x] = variable_registers_[x] - variable_registers_[y];
 }
 
-void Emulator::VySubtractVx(uint8_t x, uint8_t y) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::VySubtractVx(uint8_t x, uint8_t y) {
   if (variable_registers_[y] > variable_registers_[x])
     variable_registers_[0xF] = 1;
   else
@@ -382,7 +1044,9 @@ void Emulator::VySubtractVx(uint8_t x, uint8_t y) {
   variable_registers_[x] = variable_registers_[y] - variable_registers_[x];
 }
 
-void Emulator::ShiftVxRight(uint8_t x) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ShiftVxRight(uint8_t x, uint8_t y) {
+  if constexpr (kQuirks.shift_reads_vy) variable_registers_[x] = variable_registers_[y];
   int shifted{ variable_registers_[x] & 0x1 };
   if (shifted > 0)
     variable_registers_[0xF] = 1;
@@ -391,8 +1055,10 @@ void Emulator::ShiftVxRight(uint8_t x) {
   variable_registers_[x] >>= 1;
 }
 
-void Emulator::ShiftVxLeft(uint8_t x) {
-  int shifted{ variable_registers_[x] & 0x8 };
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::ShiftVxLeft(uint8_t x, uint8_t y) {
+  if constexpr (kQuirks.shift_reads_vy) variable_registers_[x] = variable_registers_[y];
+  int shifted{ variable_registers_[x] & 0x80 };
   if (shifted > 0)
     variable_registers_[0xF] = 1;
   else
@@ -400,50 +1066,67 @@ void Emulator::ShiftVxLeft(uint8_t x) {
   variable_registers_[x] <<= 1;
 }
 
-void Emulator::JumpWithOffset(uint16_t address) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::JumpWithOffset(uint16_t address) {
   program_counter_ = address;
-  program_counter_ += variable_registers_[0x0];
+  program_counter_ += variable_registers_[kQuirks.jump_reads_vx ? (address >> 8) & 0xF : 0x0];
 }
 
-void Emulator::VxBinaryAndRandom(uint8_t x, uint8_t value) {
-  int random = std::rand() % 8;
-  variable_registers_[x] = random & value;
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::VxBinaryAndRandom(uint8_t x, uint8_t value) {
+  variable_registers_[x] = random_.NextByte() & value;
 }
 
-void Emulator::AddVx2IndexRegister(uint8_t x) { index_register_ += variable_registers_[x]; }
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::AddVx2IndexRegister(uint8_t x) { index_register_ += variable_registers_[x]; }
 
-void Emulator::SetIndexRegisterForFont(uint8_t x) { index_register_ = variable_registers_[x]; }
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetIndexRegisterForFont(uint8_t x) { index_register_ = variable_registers_[x]; }
 
-void Emulator::HexInVxToDecimal(uint8_t x) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::HexInVxToDecimal(uint8_t x) {
   uint8_t hex_number{ variable_registers_[x] };
-  memory_[index_register_] = hex_number / 100;
-  memory_[index_register_ + 1] = (hex_number / 10) % 10;
-  memory_[index_register_ + 2] = (hex_number % 100) % 10;
+  WriteMemory(index_register_, hex_number / 100);
+  WriteMemory(index_register_ + 1, (hex_number / 10) % 10);
+  WriteMemory(index_register_ + 2, (hex_number % 100) % 10);
 }
 
-void Emulator::StoreRegistersInMemory(uint8_t x) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::StoreRegistersInMemory(uint8_t x) {
   for (size_t i = 0; i <= x; ++i) {
-    memory_[index_register_ + i] = variable_registers_[i];
+    WriteMemory(index_register_ + i, variable_registers_[i]);
   }
+  if constexpr (kQuirks.load_store_advances_index) index_register_ += x + 1;
 }
 
-void Emulator::LoadRegistersFromMemory(uint8_t x) {
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::LoadRegistersFromMemory(uint8_t x) {
   for (size_t i = 0; i <= x; ++i) {
     variable_registers_[i] = memory_[index_register_ + i];
   }
+  if constexpr (kQuirks.load_store_advances_index) index_register_ += x + 1;
 }
 
-void Emulator::WaitForKeyPress(uint8_t x) {
-  std::optional<uint8_t> key{ Keyboard::WaitForKeyPress(screen_) };
-  if (!key.has_value()) return;
-
-  variable_registers_[x] = *key;
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::WaitForKeyPress(uint8_t x) {
+  key_wait_register_ = x;
+  ResolveKeyWait();
 }
 
-void Emulator::SetDelayTimer(uint8_t x) { delay_timer_ = variable_registers_[x]; }
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetDelayTimer(uint8_t x) { delay_timer_ = variable_registers_[x]; }
+
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetSoundTimer(uint8_t x) {
+  sound_timer_ = variable_registers_[x];
+  speaker_.Beep(sound_timer_);
+};
 
-void Emulator::SetSoundTimer(uint8_t x) { sound_timer_ = variable_registers_[x]; }
+template <Quirks kQuirks>
+void BasicEmulator<kQuirks>::SetDelayTimer2Vx(uint8_t x) { variable_registers_[x] = delay_timer_; }
 
-void Emulator::SetDelayTimer2Vx(uint8_t x) { variable_registers_[x] = delay_timer_; }
+#define CHIP8_INSTANTIATE_EMULATOR(profile, name) template class BasicEmulator<profile>;
+CHIP8_QUIRK_PROFILES(CHIP8_INSTANTIATE_EMULATOR)
+#undef CHIP8_INSTANTIATE_EMULATOR
 
 }  // namespace chip8
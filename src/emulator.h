@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cstdint>
@@ -7,19 +8,32 @@
 #include <string>
 #include <vector>
 
+#include "framebuffer.h"
+#include "keyboard.h"
+#include "machine_state.h"
+#include "paged_memory.h"
+#include "profiler.h"
+#include "quirks.h"
+#include "random.h"
+#include "rewind.h"
+#include "save_state.h"
 #include "screen.h"
 #include "speaker.h"
+#include "telemetry.h"
 
 namespace chip8 {
 
-class Emulator {
+// The parts of the emulator that do not depend on its quirks, shared by every BasicEmulator instantiation.
+class EmulatorBase {
  public:
   static inline const uint16_t kChip8MemorySize{ 4096 };
   static inline const uint16_t kChip8ProgramStartAddress{ 0x200 };
-  static inline const uint8_t kChip8ScreenWidth{ 64 };
-  static inline const uint8_t kChip8ScreenHeight{ 32 };
+  static inline const uint8_t kChip8ScreenWidth{ kLowResFramebufferWidth };
+  static inline const uint8_t kChip8ScreenHeight{ kLowResFramebufferHeight };
+  static inline const uint32_t kChip8TimerFrequency{ 60 };
+  static inline const uint32_t kChip8DefaultClockSpeed{ 700 };
 
-  static inline const std::vector<uint8_t> kChip8FontSet = {
+  static constexpr std::array<uint8_t, 80> kChip8FontSet{
     0xF0, 0x90, 0x90, 0x90, 0xF0, 0x20, 0x60, 0x20, 0x20, 0x70, 0xF0, 0x10, 0xF0, 0x80, 0xF0, 0xF0,
     0x10, 0xF0, 0x10, 0xF0, 0x90, 0x90, 0xF0, 0x10, 0x10, 0xF0, 0x80, 0xF0, 0x10, 0xF0, 0xF0, 0x80,
     0xF0, 0x90, 0xF0, 0xF0, 0x10, 0x20, 0x40, 0x40, 0xF0, 0x90, 0xF0, 0x90, 0xF0, 0xF0, 0x90, 0xF0,
@@ -27,12 +41,30 @@ class Emulator {
     0xF0, 0xE0, 0x90, 0x90, 0x90, 0xE0, 0xF0, 0x80, 0xF0, 0x80, 0xF0, 0xF0, 0x80, 0xF0, 0x80, 0x80
   };
 
-  explicit Emulator(const std::string& filename, Screen& screen, Speaker& speaker,
-                    std::chrono::microseconds delay);
+  // Memory of every instance before its program is loaded: the font set at address 0, zeros elsewhere.
+  static constexpr std::array<uint8_t, kChip8MemorySize> kChip8InitialMemory{ [] {
+    std::array<uint8_t, kChip8MemorySize> memory{};
+    std::copy(kChip8FontSet.begin(), kChip8FontSet.end(), memory.begin());
+    return memory;
+  }() };
 
-  void StartExecutionLoop();
+  enum class Engine {
+    // Fetches and decodes every instruction from memory.
+    kInterpreter,
+    // Decodes each instruction address once and reuses the result until that memory is written.
+    kPredecoded,
+    // Splits the program into basic blocks of predecoded instructions ending at control flow, and runs a
+    // whole block per dispatch. Blocks are dropped when memory they cover is written.
+    kBlocks,
+  };
+
+  enum class Mode {
+    // Paces frames to 60 Hz wall-clock time.
+    kRealtime,
+    // Runs frames back to back as fast as possible; only the virtual clock advances.
+    kTurbo,
+  };
 
- private:
   struct Instruction {
     uint16_t raw;
     uint8_t first_nibble;
@@ -41,15 +73,118 @@ class Emulator {
     uint8_t fourth_nibble;
   };
 
+  static Instruction Decode(std::array<uint8_t, 2> instr);
+};
+
+// CHIP-8 interpreter compiled for one set of quirks. Every profile in CHIP8_QUIRK_PROFILES is explicitly
+// instantiated in emulator.cc; Emulator is the one with kModernQuirks.
+template <Quirks kQuirks>
+class BasicEmulator : public EmulatorBase {
+ public:
+  // `clock_speed` is the number of instructions executed per emulated second. The delay and sound timers
+  // tick on a virtual 60 Hz clock derived from the cycle count, so a frame is clock_speed / 60 instructions
+  // (spread evenly when it does not divide) in both modes.
+  explicit BasicEmulator(const std::string& filename, Screen& screen, Speaker& speaker, Keyboard& keyboard,
+                         uint32_t clock_speed = kChip8DefaultClockSpeed, Mode mode = Mode::kRealtime,
+                         Engine engine = Engine::kInterpreter);
+
+  // Forks `parent` at its current state onto new devices. Memory pages stay shared with the parent until
+  // either side writes to them, so forking costs little more than copying the registers and caches.
+  explicit BasicEmulator(const BasicEmulator& parent, Screen& screen, Speaker& speaker, Keyboard& keyboard);
+
+  void StartExecutionLoop();
+
+  // Executes a single fetch/decode/execute cycle followed by a timers tick. Lets hosts without a window
+  // drive the emulator for an exact number of cycles.
+  void Step();
+
+  // Executes instructions up to and including the next 60 Hz timers tick, then presents the frame.
+  void RunFrame();
+
+  // Draws the framebuffer to the screen if it changed since the last present. Sprite and clear opcodes only
+  // mark it dirty, so the screen is redrawn at most once per call no matter how many of them executed.
+  void Present();
+
+  uint64_t Cycles() const { return cycles_; }
+
+  // True while FX0A waits for a key. Waiting does not block: cycles and timers keep running, and RunFrame
+  // skips the rest of any frame in which no key is held.
+  bool IsWaitingForKey() const { return key_wait_register_.has_value(); }
+
+  // Restarts the random sequence CXNN draws from. Instances get distinct seeds derived from one read of
+  // std::random_device per process; seed them explicitly for reproducible runs.
+  void Seed(uint64_t seed) { random_.Seed(seed); }
+
+  // Memory pages not shared with any parent, fork or the ROM cache.
+  size_t PrivateMemoryPages() const { return memory_.PrivatePages(); }
+
+  MachineState CaptureState() const;
+
+#if defined(CHIP8_PROFILE)
+  // Statistics gathered since construction. Only instructions run by the engines are counted, not those
+  // passed to ExecuteOpcode.
+  const Profile& GetProfile() const { return profile_; }
+#endif
+
+  // Captures everything needed to resume execution later, including the cycle count and virtual clock.
+  SaveState Snapshot() const;
+
+  // Resumes from `state`, which may come from an instance running a different engine. Throws
+  // std::invalid_argument if the state has the wrong magic or version or is out of range. Predecoded
+  // instructions and blocks are dropped, the screen is redrawn on the next present and the speaker sounds
+  // whatever is left of the sound timer.
+  void Restore(const SaveState& state);
+
+  // Records the state at the end of every frame into `buffer`, or stops recording when null. Frames after
+  // the first pass the buffer only the registers, the framebuffer rows and the memory pages they may have
+  // changed, so the buffer's newest state must stay this instance's: restore whatever StepBack returns
+  // before running on. The buffer must outlive the emulator or be detached first.
+  void AttachRewindBuffer(RewindBuffer* buffer);
+
+  // Reports frame times, scheduler overshoot, keypad changes and presents to `telemetry`, or stops reporting
+  // when null. The telemetry must outlive the emulator or be detached first.
+  void AttachTelemetry(Telemetry* telemetry) { telemetry_ = telemetry; }
+
+  // Executes `raw` as if it had just been fetched at the program counter, without advancing the cycle count
+  // or timers. Meant for benchmarks and tooling that exercise single opcodes.
+  void ExecuteOpcode(uint16_t raw);
+
+ private:
+  // Predecode cache entry for the instruction at an even address.
+  struct DecodedInstruction {
+    Instruction instr;
+    uint8_t operation;
+    bool valid;
+  };
+
+  // Longest basic block ever translated, in instructions.
+  static inline const uint8_t kMaxBlockLength{ 32 };
+  // `rewind_pages_` with every page of memory set.
+  static inline const uint16_t kAllPages{ 0xFFFF };
+  static_assert(PagedMemory::kPageCount == 16, "rewind_pages_ holds one bit per page");
+
   void LoadProgramText(const std::string& filename);
-  void LoadFontSet();
 
   std::optional<std::array<uint8_t, 2>> Fetch();
-  static Instruction Decode(std::array<uint8_t, 2> instr);
   void Execute(const Instruction& instr);
+  void ExecuteOperation(uint8_t operation, const Instruction& instr);
+  void Interpret();
+  void ExecutePredecoded();
+  DecodedInstruction& PredecodedAt(size_t index);
+  uint64_t ExecuteBlock(uint64_t budget);
+  uint8_t TranslateBlock(size_t start);
+  void WriteMemory(uint16_t address, uint8_t value);
+  void RecordRewindFrame();
+  uint16_t Keypad();
+  bool ResolveKeyWait();
   void OnTimersTick();
+  uint64_t NextTimerTickCycle() const;
 
   void ClearScreen();
+  void ScrollDown(uint8_t n);
+  void ScrollRight();
+  void ScrollLeft();
+  void SetResolution(bool hires);
   void Jump(uint16_t address);
   void SetRegisterVx(uint8_t x, uint8_t value);
   void AddToRegisterVx(uint8_t x, uint8_t value);
@@ -70,8 +205,8 @@ class Emulator {
   void AddVy2Vx(uint8_t x, uint8_t y);
   void VxSubtractVy(uint8_t x, uint8_t y);
   void VySubtractVx(uint8_t x, uint8_t y);
-  void ShiftVxRight(uint8_t x);
-  void ShiftVxLeft(uint8_t x);
+  void ShiftVxRight(uint8_t x, uint8_t y);
+  void ShiftVxLeft(uint8_t x, uint8_t y);
   void JumpWithOffset(uint16_t address);
   void VxBinaryAndRandom(uint8_t x, uint8_t value);
   void AddVx2IndexRegister(uint8_t x);
@@ -87,16 +222,51 @@ class Emulator {
   std::array<uint8_t, 16> variable_registers_{};
   std::array<uint16_t, 16> stack_{};
   uint8_t stack_pointer_{ 0 };
-  std::array<uint8_t, kChip8MemorySize> memory_{};
+  PagedMemory memory_;
   int program_counter_{ kChip8ProgramStartAddress };
-  std::array<std::array<uint8_t, kChip8ScreenWidth>, kChip8ScreenHeight> screen_matrix_;
+  Framebuffer screen_matrix_{};
   uint16_t index_register_{ 0 };
   uint8_t delay_timer_{ 0 };
   uint8_t sound_timer_{ 0 };
+  bool screen_dirty_{ false };
+  uint64_t cycles_{ 0 };
+  uint64_t timer_ticks_{ 0 };
+  uint64_t next_timer_tick_cycle_{ 0 };
+  Random random_;
+  // Keypad latched for frame `keypad_frame_`, see Keyboard::LatchKeys.
+  uint16_t keypad_{ 0 };
+  std::optional<uint64_t> keypad_frame_;
+  // Register FX0A stores the next key into while the instance waits for one.
+  std::optional<uint8_t> key_wait_register_;
+  // One entry per even address, only allocated for Engine::kPredecoded and Engine::kBlocks.
+  std::vector<DecodedInstruction> predecoded_;
+  // Length of the basic block starting at each even address, 0 if not translated. Only allocated for
+  // Engine::kBlocks.
+  std::vector<uint8_t> block_lengths_;
 
-  std::chrono::microseconds delay_;
+  uint32_t clock_speed_;
+  Mode mode_;
+  Engine engine_;
   Screen& screen_;
   Speaker& speaker_;
+  Keyboard& keyboard_;
+  RewindBuffer* rewind_{ nullptr };
+  // What changed since the last frame recorded to `rewind_`: bit N of `rewind_pages_` for each page of
+  // memory written, and `rewind_drawn_` if the framebuffer was presented. `rewind_hires_` is the resolution
+  // of that frame.
+  uint16_t rewind_pages_{ 0 };
+  bool rewind_drawn_{ false };
+  bool rewind_hires_{ false };
+  Telemetry* telemetry_{ nullptr };
+#if defined(CHIP8_PROFILE)
+  Profile profile_;
+#endif
 };
 
+#define CHIP8_DECLARE_EMULATOR(profile, name) extern template class BasicEmulator<profile>;
+CHIP8_QUIRK_PROFILES(CHIP8_DECLARE_EMULATOR)
+#undef CHIP8_DECLARE_EMULATOR
+
+using Emulator = BasicEmulator<kModernQuirks>;
+
 }  // namespace chip8
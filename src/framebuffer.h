@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace chip8 {
+
+// The SUPER-CHIP high resolution display, the largest one the core draws.
+static inline const size_t kFramebufferWidth{ 128 };
+static inline const size_t kFramebufferHeight{ 64 };
+// The original display, in use until a program switches to high resolution.
+static inline const size_t kLowResFramebufferWidth{ 64 };
+static inline const size_t kLowResFramebufferHeight{ 32 };
+
+// Monochrome display packed one bit per pixel. The most significant bit of a word is its leftmost pixel, so
+// a sprite row lands on the screen with a single shift.
+//
+// Each 128-pixel row is split into a left and a right word kept in separate arrays rather than interleaved,
+// so row-wise operations such as scrolling are straight loops over each array that compilers vectorize. At
+// low resolution a row is only its left word, and only the first 32 rows are used; everything else is zero.
+struct Framebuffer {
+  std::array<uint64_t, kFramebufferHeight> left{};
+  std::array<uint64_t, kFramebufferHeight> right{};
+  bool hires{ false };
+
+  size_t Width() const { return hires ? kFramebufferWidth : kLowResFramebufferWidth; }
+  size_t Height() const { return hires ? kFramebufferHeight : kLowResFramebufferHeight; }
+
+  bool operator==(const Framebuffer&) const = default;
+};
+
+// `x` and `y` are in pixels of the framebuffer's current resolution.
+inline bool IsPixelSet(const Framebuffer& framebuffer, size_t x, size_t y) {
+  const uint64_t word{ x < 64 ? framebuffer.left[y] : framebuffer.right[y] };
+  return (word >> (63 - (x & 63))) & 1;
+}
+
+static inline const uint64_t kFramebufferHashSeed{ 0xcbf29ce484222325 };
+
+// FNV-1a over the visible words of a frame, a word at a time. Words outside the current resolution are
+// always zero and left out, so low resolution frames hash the same as before the high resolution display
+// existed. Passing the previous frame's hash as `seed` chains the hashes of a run into one value that
+// changes if any frame does.
+inline uint64_t HashFramebuffer(const Framebuffer& framebuffer, uint64_t seed = kFramebufferHashSeed) {
+  uint64_t hash{ seed };
+  for (size_t y = 0; y < framebuffer.Height(); ++y) {
+    hash ^= framebuffer.left[y];
+    hash *= 0x100000001b3;
+    if (framebuffer.hires) {
+      hash ^= framebuffer.right[y];
+      hash *= 0x100000001b3;
+    }
+  }
+  return hash;
+}
+
+}  // namespace chip8
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "framebuffer.h"
+#include "keyboard.h"
+#include "screen.h"
+#include "speaker.h"
+
+namespace chip8 {
+
+// Frontends that need neither a window nor an audio device. They let the core run in regression and
+// fuzzing hosts where thousands of instances share one box.
+
+// Keeps the most recently drawn frame in memory.
+class MemoryScreen : public Screen {
+ public:
+  bool IsOpen() override { return open_; }
+
+  void Draw(const Framebuffer& screen) override {
+    frame_ = screen;
+    ++draw_count_;
+  }
+
+  void Close() { open_ = false; }
+
+  const Framebuffer& Frame() const { return frame_; }
+  size_t DrawCount() const { return draw_count_; }
+
+ private:
+  Framebuffer frame_{};
+  size_t draw_count_{ 0 };
+  bool open_{ true };
+};
+
+// Discards sound, only counting the beeps it was asked to start.
+class NullSpeaker : public Speaker {
+ public:
+  void Beep(uint8_t ticks) override {
+    if (ticks > 0) ++beep_count_;
+  }
+
+  size_t BeepCount() const { return beep_count_; }
+
+ private:
+  size_t beep_count_{ 0 };
+};
+
+// Keypad whose state is set directly by the host.
+class MemoryKeyboard : public Keyboard {
+ public:
+  bool IsKeyPressed(uint8_t key) override { return pressed_[key & 0xF]; }
+
+  void Press(uint8_t key) { pressed_[key & 0xF] = true; }
+  void Release(uint8_t key) { pressed_[key & 0xF] = false; }
+
+  // Sets the whole keypad at once; bit N is key N.
+  void SetKeys(uint16_t keys) {
+    for (uint8_t key = 0; key < pressed_.size(); ++key) {
+      pressed_[key] = (keys >> key) & 1;
+    }
+  }
+
+ private:
+  std::array<bool, 16> pressed_{};
+};
+
+}  // namespace chip8
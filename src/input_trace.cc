@@ -0,0 +1,200 @@
+#include "input_trace.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace chip8 {
+
+namespace {
+
+void AppendUint16(std::vector<uint8_t>& out, uint16_t value) {
+  out.push_back(static_cast<uint8_t>(value & 0xFF));
+  out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void AppendUint32(std::vector<uint8_t>& out, uint32_t value) {
+  AppendUint16(out, static_cast<uint16_t>(value & 0xFFFF));
+  AppendUint16(out, static_cast<uint16_t>(value >> 16));
+}
+
+void AppendUint64(std::vector<uint8_t>& out, uint64_t value) {
+  AppendUint32(out, static_cast<uint32_t>(value & 0xFFFFFFFF));
+  AppendUint32(out, static_cast<uint32_t>(value >> 32));
+}
+
+// Reads little endian fields from an encoded trace, throwing once it runs past the end.
+class Reader {
+ public:
+  explicit Reader(std::span<const uint8_t> bytes) : bytes_{ bytes } {};
+
+  bool AtEnd() const { return offset_ == bytes_.size(); }
+
+  uint8_t Byte() {
+    if (AtEnd()) {
+      throw std::invalid_argument{ "truncated input trace" };
+    }
+    return bytes_[offset_++];
+  }
+
+  uint16_t Uint16() {
+    const uint8_t low{ Byte() };
+    return static_cast<uint16_t>(low | (Byte() << 8));
+  }
+
+  uint32_t Uint32() {
+    const uint16_t low{ Uint16() };
+    return low | (static_cast<uint32_t>(Uint16()) << 16);
+  }
+
+  uint64_t Uint64() {
+    const uint32_t low{ Uint32() };
+    return low | (static_cast<uint64_t>(Uint32()) << 32);
+  }
+
+  uint64_t Leb128() {
+    uint64_t value{ 0 };
+    for (int shift = 0; shift < 64; shift += 7) {
+      const uint8_t byte{ Byte() };
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) return value;
+    }
+    throw std::invalid_argument{ "malformed frame delta in input trace" };
+  }
+
+ private:
+  std::span<const uint8_t> bytes_;
+  size_t offset_{ 0 };
+};
+
+}  // namespace
+
+void InputTrace::Append(const Event& event) {
+  if (!events_.empty() && event.frame < events_.back().frame) {
+    throw std::invalid_argument{ "input trace events must be in frame order" };
+  }
+  events_.push_back(event);
+};
+
+std::vector<uint8_t> InputTrace::Encode() const {
+  if (!setup_.has_value()) {
+    throw std::invalid_argument{ "input trace has no setup" };
+  }
+  if (setup_->quirks.size() > 0xFF) {
+    throw std::invalid_argument{ "quirks profile name too long for an input trace" };
+  }
+
+  std::vector<uint8_t> encoded;
+  AppendUint32(encoded, kMagic);
+  AppendUint16(encoded, kVersion);
+  AppendUint64(encoded, setup_->seed);
+  AppendUint32(encoded, setup_->clock_speed);
+  encoded.push_back(static_cast<uint8_t>(setup_->quirks.size()));
+  encoded.insert(encoded.end(), setup_->quirks.begin(), setup_->quirks.end());
+
+  uint64_t frame{ 0 };
+  for (const Event& event : events_) {
+    uint64_t delta{ event.frame - frame };
+    frame = event.frame;
+    do {
+      encoded.push_back(static_cast<uint8_t>((delta & 0x7F) | (delta > 0x7F ? 0x80 : 0)));
+      delta >>= 7;
+    } while (delta != 0);
+    encoded.push_back(static_cast<uint8_t>(event.kind));
+    AppendUint16(encoded, event.value);
+  }
+  return encoded;
+};
+
+InputTrace InputTrace::Decode(std::span<const uint8_t> encoded) {
+  Reader reader{ encoded };
+  if (reader.Uint32() != kMagic || reader.Uint16() != kVersion) {
+    throw std::invalid_argument{ "unsupported input trace format" };
+  }
+
+  InputTrace trace;
+  Setup setup;
+  setup.seed = reader.Uint64();
+  setup.clock_speed = reader.Uint32();
+  const uint8_t quirks_length{ reader.Byte() };
+  for (uint8_t i = 0; i < quirks_length; ++i) {
+    setup.quirks += static_cast<char>(reader.Byte());
+  }
+  trace.setup_ = setup;
+
+  uint64_t frame{ 0 };
+  while (!reader.AtEnd()) {
+    frame += reader.Leb128();
+    const uint8_t kind{ reader.Byte() };
+    if (kind != static_cast<uint8_t>(Kind::kKeys)) {
+      throw std::invalid_argument{ "unknown input trace event" };
+    }
+    trace.events_.push_back({ .frame = frame, .kind = static_cast<Kind>(kind), .value = reader.Uint16() });
+  }
+  return trace;
+};
+
+void InputTrace::Save(const std::string& filename) const {
+  std::ofstream file{ filename, std::ios::out | std::ios::binary | std::ios::trunc };
+  if (!file) {
+    throw std::invalid_argument{ "failed to open input trace for writing" };
+  }
+
+  const std::vector<uint8_t> encoded{ Encode() };
+  file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+  if (!file.good()) {
+    throw std::runtime_error{ "Error writing input trace" };
+  }
+};
+
+InputTrace InputTrace::Load(const std::string& filename) {
+  std::ifstream file{ filename, std::ios::in | std::ios::binary };
+  if (!file) {
+    throw std::invalid_argument{ "failed to open input trace" };
+  }
+
+  const std::vector<uint8_t> encoded{ std::istreambuf_iterator<char>{ file },
+                                      std::istreambuf_iterator<char>{} };
+  return Decode(encoded);
+};
+
+uint16_t InputRecorder::LatchKeys(uint64_t frame) {
+  const uint16_t keys{ source_.LatchKeys(frame) };
+  if (keys_ != keys) {
+    trace_.Append({ .frame = frame, .kind = InputTrace::Kind::kKeys, .value = keys });
+    keys_ = keys;
+  }
+  return keys;
+};
+
+InputPlayer::InputPlayer(const InputTrace& trace, const InputTrace::Setup& setup) : trace_{ trace } {
+  const std::optional<InputTrace::Setup>& recorded{ trace.GetSetup() };
+  if (!recorded.has_value()) return;
+
+  if (recorded->seed != setup.seed) {
+    throw std::invalid_argument{ "input trace was recorded with seed " + std::to_string(recorded->seed) };
+  }
+  if (recorded->clock_speed != setup.clock_speed) {
+    throw std::invalid_argument{ "input trace was recorded at clock speed " +
+                                 std::to_string(recorded->clock_speed) };
+  }
+  if (recorded->quirks != setup.quirks) {
+    throw std::invalid_argument{ "input trace was recorded with quirks profile " + recorded->quirks };
+  }
+};
+
+uint16_t InputPlayer::LatchKeys(uint64_t frame) {
+  const std::vector<InputTrace::Event>& events{ trace_.Events() };
+  while (next_ < events.size() && events[next_].frame <= frame) {
+    keys_ = events[next_++].value;
+  }
+  return keys_;
+};
+
+}  // namespace chip8
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "keyboard.h"
+
+namespace chip8 {
+
+// Keypad input of one run: every change of the latched keypad state, timestamped by emulated frame. Key tests
+// and FX0A waits only ever see latched states, so replaying the trace through an InputPlayer reproduces the
+// run bit for bit at any speed.
+//
+// A trace only reproduces its run together with everything else the run's outcome depends on, so it also
+// records the setup the run was recorded under.
+//
+// The binary form is a `C8IT` magic and version, the setup as `<uint64 seed><uint32 clock speed><uint8
+// length><quirks profile name>`, then one record per event:
+// `<LEB128 frames since the previous event><kind byte><uint16 little endian value>`. All integers are little
+// endian.
+class InputTrace {
+ public:
+  static inline const uint32_t kMagic{ 0x54493843 };  // "C8IT" read as little endian
+  static inline const uint16_t kVersion{ 3 };
+
+  struct Setup {
+    // Passed to BasicEmulator::Seed.
+    uint64_t seed{ 0 };
+    uint32_t clock_speed{ 0 };
+    // Name of the profile in CHIP8_QUIRK_PROFILES.
+    std::string quirks;
+
+    bool operator==(const Setup&) const = default;
+  };
+
+  enum class Kind : uint8_t {
+    // `value` is the keypad state latched from this frame on.
+    kKeys,
+  };
+
+  struct Event {
+    uint64_t frame;
+    Kind kind;
+    uint16_t value;
+
+    bool operator==(const Event&) const = default;
+  };
+
+  void Append(const Event& event);
+  const std::vector<Event>& Events() const { return events_; }
+
+  // Unset until recorded or decoded. A trace without a setup constrains no run.
+  void SetSetup(const Setup& setup) { setup_ = setup; }
+  const std::optional<Setup>& GetSetup() const { return setup_; }
+
+  // Throws std::invalid_argument if the setup is unset or its profile name is longer than 255 bytes.
+  std::vector<uint8_t> Encode() const;
+  // Throws std::invalid_argument on a malformed trace.
+  static InputTrace Decode(std::span<const uint8_t> encoded);
+
+  void Save(const std::string& filename) const;
+  static InputTrace Load(const std::string& filename);
+
+ private:
+  std::optional<Setup> setup_;
+  std::vector<Event> events_;
+};
+
+// Forwards a live keyboard to the emulator and appends what the emulator saw to a trace.
+class InputRecorder : public Keyboard {
+ public:
+  InputRecorder(Keyboard& source, InputTrace& trace) : source_{ source }, trace_{ trace } {};
+
+  bool IsKeyPressed(uint8_t key) override { return source_.IsKeyPressed(key); }
+  uint16_t LatchKeys(uint64_t frame) override;
+
+ private:
+  Keyboard& source_;
+  InputTrace& trace_;
+  std::optional<uint16_t> keys_;
+};
+
+// Feeds a recorded trace back to the emulator. Once the trace is exhausted the last keypad state holds.
+class InputPlayer : public Keyboard {
+ public:
+  // `setup` is what the emulator being driven runs under. Throws std::invalid_argument naming the first
+  // difference if the trace was recorded under another one, since the replay would silently diverge.
+  InputPlayer(const InputTrace& trace, const InputTrace::Setup& setup);
+
+  bool IsKeyPressed(uint8_t key) override { return (keys_ >> (key & 0xF)) & 1; }
+  uint16_t LatchKeys(uint64_t frame) override;
+
+  // Whether latching frame `frame` applies an event not yet played.
+  bool IsInputDue(uint64_t frame) const {
+    return next_ < trace_.Events().size() && trace_.Events()[next_].frame <= frame;
+  }
+
+ private:
+  const InputTrace& trace_;
+  size_t next_{ 0 };
+  uint16_t keys_{ 0 };
+};
+
+}  // namespace chip8
@@ -0,0 +1,428 @@
+#include "lockstep.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "emulator.h"
+#include "headless.h"
+#include "machine_state.h"
+#include "operations.h"
+
+namespace chip8 {
+
+namespace {
+
+MachineState LoadInitialState(const std::string& filename) {
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  return Emulator{ filename, screen, speaker, keyboard }.CaptureState();
+}
+
+}  // namespace
+
+LockstepEngine::LockstepEngine(const std::string& filename, size_t lanes, uint64_t seed, uint32_t clock_speed)
+    : LockstepEngine{ LoadInitialState(filename), lanes, clock_speed } {
+  for (size_t lane = 0; lane < lanes_; ++lane) {
+    randoms_[lane].Seed(seed + lane);
+  }
+};
+
+LockstepEngine::LockstepEngine(const MachineState& initial, size_t lanes, uint32_t clock_speed)
+    : lanes_{ lanes },
+      registers_(initial.variable_registers.size() * lanes),
+      stack_(initial.stack.size() * lanes),
+      stack_pointer_(lanes, initial.stack_pointer),
+      program_counter_(lanes, initial.program_counter),
+      index_register_(lanes, initial.index_register),
+      delay_timer_(lanes, initial.delay_timer),
+      sound_timer_(lanes, initial.sound_timer),
+      framebuffer_(Emulator::kChip8ScreenHeight * lanes),
+      memory_(initial.memory.size() * lanes),
+      keys_(lanes),
+      randoms_(lanes),
+      key_wait_(lanes, initial.key_wait_register.value_or(kNotWaiting)),
+      clock_speed_{ clock_speed } {
+  if (lanes_ == 0) {
+    throw std::invalid_argument{ "lockstep engine needs at least one lane" };
+  }
+  if (clock_speed_ == 0) {
+    throw std::invalid_argument{ "clock speed must be positive" };
+  }
+  if (initial.framebuffer.hires) {
+    throw std::invalid_argument{ "lockstep engine only runs the low resolution display" };
+  }
+  next_timer_tick_cycle_ = NextTimerTickCycle();
+
+  for (size_t lane = 0; lane < lanes_; ++lane) {
+    for (size_t x = 0; x < initial.variable_registers.size(); ++x) {
+      registers_[x * lanes_ + lane] = initial.variable_registers[x];
+    }
+    for (size_t i = 0; i < initial.stack.size(); ++i) {
+      stack_[i * lanes_ + lane] = initial.stack[i];
+    }
+    for (size_t y = 0; y < Emulator::kChip8ScreenHeight; ++y) {
+      framebuffer_[y * lanes_ + lane] = initial.framebuffer.left[y];
+    }
+    std::copy(initial.memory.begin(), initial.memory.end(), Memory(lane));
+    randoms_[lane].SetState(initial.random_state);
+  }
+};
+
+void LockstepEngine::Step() {
+  // Lanes waiting in FX0A spend the cycle testing their keypad instead of executing.
+  executing_.clear();
+  for (size_t lane = 0; lane < lanes_; ++lane) {
+    if (key_wait_[lane] == kNotWaiting) {
+      executing_.push_back(static_cast<uint32_t>(lane));
+    } else {
+      ResolveKeyWait(lane);
+    }
+  }
+
+  if (!executing_.empty()) {
+    // Lanes mostly run the same code in the same place, so check for that before sorting anything.
+    const uint16_t pc{ program_counter_[executing_[0]] };
+    const uint16_t opcode{ OpcodeAt(executing_[0], pc) };
+    const bool shared{ std::all_of(executing_.begin(), executing_.end(), [&](uint32_t lane) {
+      return program_counter_[lane] == pc && OpcodeAt(lane, pc) == opcode;
+    }) };
+    if (shared) {
+      Execute(opcode, executing_);
+    } else {
+      ExecuteGroups();
+    }
+  }
+
+  ++cycles_;
+  OnTimersTick();
+};
+
+void LockstepEngine::ExecuteGroups() {
+  // Sorting lanes by instruction lines up every group contiguously, in O(lanes log lanes) however many
+  // groups there are.
+  instructions_.clear();
+  for (uint32_t lane : executing_) {
+    const uint16_t pc{ program_counter_[lane] };
+    instructions_.push_back(static_cast<uint64_t>(pc) << 48 |
+                            static_cast<uint64_t>(OpcodeAt(lane, pc)) << 32 | lane);
+  }
+  std::sort(instructions_.begin(), instructions_.end());
+
+  for (size_t begin = 0; begin < instructions_.size();) {
+    const uint64_t instruction{ instructions_[begin] >> 32 };
+    group_.clear();
+    size_t end{ begin };
+    for (; end < instructions_.size() && instructions_[end] >> 32 == instruction; ++end) {
+      group_.push_back(static_cast<uint32_t>(instructions_[end]));
+    }
+    Execute(static_cast<uint16_t>(instruction), group_);
+    begin = end;
+  }
+};
+
+void LockstepEngine::RunFrame() {
+  const uint64_t frame{ timer_ticks_ };
+  while (timer_ticks_ == frame) {
+    Step();
+  }
+};
+
+MachineState LockstepEngine::CaptureState(size_t lane) const {
+  MachineState state{
+    .stack_pointer = stack_pointer_[lane],
+    .program_counter = program_counter_[lane],
+    .index_register = index_register_[lane],
+    .delay_timer = delay_timer_[lane],
+    .sound_timer = sound_timer_[lane],
+    .random_state = randoms_[lane].GetState(),
+  };
+  if (key_wait_[lane] != kNotWaiting) {
+    state.key_wait_register = key_wait_[lane];
+  }
+  for (size_t x = 0; x < state.variable_registers.size(); ++x) {
+    state.variable_registers[x] = registers_[x * lanes_ + lane];
+  }
+  for (size_t i = 0; i < state.stack.size(); ++i) {
+    state.stack[i] = stack_[i * lanes_ + lane];
+  }
+  for (size_t y = 0; y < Emulator::kChip8ScreenHeight; ++y) {
+    state.framebuffer.left[y] = framebuffer_[y * lanes_ + lane];
+  }
+  std::copy(Memory(lane), Memory(lane) + state.memory.size(), state.memory.begin());
+  return state;
+};
+
+void LockstepEngine::ResolveKeyWait(size_t lane) {
+  if (keys_[lane] == 0) return;
+
+  Registers(key_wait_[lane])[lane] = static_cast<uint8_t>(std::countr_zero(keys_[lane]));
+  key_wait_[lane] = kNotWaiting;
+};
+
+uint16_t LockstepEngine::OpcodeAt(size_t lane, uint16_t address) const {
+  const uint8_t* memory{ Memory(lane) };
+  return static_cast<uint16_t>(memory[address & (Emulator::kChip8MemorySize - 1)] << 8) |
+         memory[(address + 1) & (Emulator::kChip8MemorySize - 1)];
+};
+
+// Mirrors the scalar operations in emulator.cc lane by lane, in the exact scalar order of register writes,
+// which matters when x or y is VF. A group of every lane is the identity list, so it runs as a plain loop
+// over the lane arrays that the compiler vectorizes; smaller groups go through their lane indices.
+void LockstepEngine::Execute(uint16_t opcode, std::span<const uint32_t> group) {
+  const uint8_t x{ static_cast<uint8_t>((opcode >> 8) & 0xF) };
+  const uint8_t y{ static_cast<uint8_t>((opcode >> 4) & 0xF) };
+  const uint8_t n{ static_cast<uint8_t>(opcode & 0xF) };
+  const uint8_t nn{ static_cast<uint8_t>(opcode & 0xFF) };
+  const uint16_t nnn{ static_cast<uint16_t>(opcode & 0xFFF) };
+  constexpr uint16_t kAddressMask{ Emulator::kChip8MemorySize - 1 };
+
+  uint16_t* const pc{ program_counter_.data() };
+  uint16_t* const index{ index_register_.data() };
+  uint8_t* const vx{ Registers(x) };
+  uint8_t* const vy{ Registers(y) };
+  uint8_t* const vf{ Registers(0xF) };
+
+  const auto for_each_lane{ [&](auto&& body) {
+    if (group.size() == lanes_) {
+      for (size_t lane = 0; lane < lanes_; ++lane) body(lane);
+    } else {
+      for (uint32_t lane : group) body(lane);
+    }
+  } };
+
+  for_each_lane([&](size_t lane) { pc[lane] += 2; });
+
+  switch (kOperationTable[opcode]) {
+    // kModernQuirks has no extended display, so its instructions are ignored like any other 0NNN.
+    case Operation::kIgnore:
+    case Operation::kScrollDown:
+    case Operation::kScrollRight:
+    case Operation::kScrollLeft:
+    case Operation::kLowResolution:
+    case Operation::kHighResolution:
+      return;
+
+    case Operation::kClearScreen:
+      for (size_t row = 0; row < Emulator::kChip8ScreenHeight; ++row) {
+        uint64_t* const rows{ &framebuffer_[row * lanes_] };
+        for_each_lane([&](size_t lane) { rows[lane] = 0; });
+      }
+      return;
+
+    case Operation::kReturnFromSubroutine:
+      for_each_lane([&](size_t lane) {
+        pc[lane] = stack_[(stack_pointer_[lane] & 0xF) * lanes_ + lane];
+        --stack_pointer_[lane];
+      });
+      return;
+
+    case Operation::kJump:
+      for_each_lane([&](size_t lane) { pc[lane] = nnn; });
+      return;
+
+    case Operation::kCallSubroutine:
+      for_each_lane([&](size_t lane) {
+        ++stack_pointer_[lane];
+        stack_[(stack_pointer_[lane] & 0xF) * lanes_ + lane] = pc[lane];
+        pc[lane] = nnn;
+      });
+      return;
+
+    case Operation::kSkipInstructionIfVxEqual:
+      for_each_lane([&](size_t lane) { pc[lane] += vx[lane] == nn ? 2 : 0; });
+      return;
+
+    case Operation::kSkipInstructionIfVxNotEqual:
+      for_each_lane([&](size_t lane) { pc[lane] += vx[lane] != nn ? 2 : 0; });
+      return;
+
+    case Operation::kSkipInstructionIfVxEqualVy:
+      for_each_lane([&](size_t lane) { pc[lane] += vx[lane] == vy[lane] ? 2 : 0; });
+      return;
+
+    case Operation::kSkipInstructionIfVxNotEqualVy:
+      for_each_lane([&](size_t lane) { pc[lane] += vx[lane] != vy[lane] ? 2 : 0; });
+      return;
+
+    case Operation::kSetRegisterVx:
+      for_each_lane([&](size_t lane) { vx[lane] = nn; });
+      return;
+
+    case Operation::kAddToRegisterVx:
+      for_each_lane([&](size_t lane) { vx[lane] += nn; });
+      return;
+
+    case Operation::kSetVy2Vx:
+      for_each_lane([&](size_t lane) { vx[lane] = vy[lane]; });
+      return;
+
+    case Operation::kVxBinaryOrVy:
+      for_each_lane([&](size_t lane) { vx[lane] |= vy[lane]; });
+      return;
+
+    case Operation::kVxBinaryAndVy:
+      for_each_lane([&](size_t lane) { vx[lane] &= vy[lane]; });
+      return;
+
+    case Operation::kVxBinaryXorVy:
+      for_each_lane([&](size_t lane) { vx[lane] ^= vy[lane]; });
+      return;
+
+    case Operation::kAddVy2Vx:
+      for_each_lane([&](size_t lane) {
+        const int result{ vx[lane] + vy[lane] };
+        vf[lane] = result > 255;
+        vx[lane] = result;
+      });
+      return;
+
+    case Operation::kVxSubtractVy:
+      for_each_lane([&](size_t lane) {
+        vf[lane] = vx[lane] > vy[lane];
+        vx[lane] = vx[lane] - vy[lane];
+      });
+      return;
+
+    case Operation::kShiftVxRight:
+      for_each_lane([&](size_t lane) {
+        vf[lane] = vx[lane] & 0x1;
+        vx[lane] >>= 1;
+      });
+      return;
+
+    case Operation::kVySubtractVx:
+      for_each_lane([&](size_t lane) {
+        vf[lane] = vy[lane] > vx[lane];
+        vx[lane] = vy[lane] - vx[lane];
+      });
+      return;
+
+    case Operation::kShiftVxLeft:
+      for_each_lane([&](size_t lane) {
+        vf[lane] = (vx[lane] & 0x80) != 0;
+        vx[lane] <<= 1;
+      });
+      return;
+
+    case Operation::kSetIndexRegister:
+      for_each_lane([&](size_t lane) { index[lane] = nnn; });
+      return;
+
+    case Operation::kJumpWithOffset:
+      for_each_lane([&](size_t lane) { pc[lane] = nnn + Registers(0x0)[lane]; });
+      return;
+
+    case Operation::kVxBinaryAndRandom:
+      for_each_lane([&](size_t lane) { vx[lane] = randoms_[lane].NextByte() & nn; });
+      return;
+
+    case Operation::kDisplay:
+      for_each_lane([&](size_t lane) {
+        const uint8_t start_from_y = vy[lane] % Emulator::kChip8ScreenHeight;
+        const uint8_t start_from_x = vx[lane] % Emulator::kChip8ScreenWidth;
+        const uint8_t* memory{ Memory(lane) };
+
+        bool collision{ false };
+        for (size_t row = 0; row < n && start_from_y + row < Emulator::kChip8ScreenHeight; ++row) {
+          const uint64_t sprite{ (static_cast<uint64_t>(memory[(index[lane] + row) & kAddressMask])
+                                  << (Emulator::kChip8ScreenWidth - 8)) >>
+                                 start_from_x };
+          uint64_t& target{ framebuffer_[(start_from_y + row) * lanes_ + lane] };
+          collision |= (target & sprite) != 0;
+          target ^= sprite;
+        }
+        vf[lane] = collision;
+      });
+      return;
+
+    case Operation::kSkipInstructionIfPressed:
+      for_each_lane([&](size_t lane) { pc[lane] += (keys_[lane] >> (vx[lane] & 0xF)) & 1 ? 2 : 0; });
+      return;
+
+    case Operation::kSkipInstructionIfNotPressed:
+      for_each_lane([&](size_t lane) { pc[lane] += (keys_[lane] >> (vx[lane] & 0xF)) & 1 ? 0 : 2; });
+      return;
+
+    case Operation::kAddVx2IndexRegister:
+      for_each_lane([&](size_t lane) { index[lane] += vx[lane]; });
+      return;
+
+    case Operation::kWaitForKeyPress:
+      for_each_lane([&](size_t lane) {
+        key_wait_[lane] = x;
+        ResolveKeyWait(lane);
+      });
+      return;
+
+    case Operation::kSetIndexRegisterForFont:
+      for_each_lane([&](size_t lane) { index[lane] = vx[lane]; });
+      return;
+
+    case Operation::kHexInVxToDecimal:
+      for_each_lane([&](size_t lane) {
+        uint8_t* memory{ Memory(lane) };
+        const uint8_t hex_number{ vx[lane] };
+        memory[index[lane] & kAddressMask] = hex_number / 100;
+        memory[(index[lane] + 1) & kAddressMask] = (hex_number / 10) % 10;
+        memory[(index[lane] + 2) & kAddressMask] = (hex_number % 100) % 10;
+      });
+      return;
+
+    case Operation::kStoreRegistersInMemory:
+      for_each_lane([&](size_t lane) {
+        uint8_t* memory{ Memory(lane) };
+        for (size_t i = 0; i <= x; ++i) {
+          memory[(index[lane] + i) & kAddressMask] = Registers(i)[lane];
+        }
+      });
+      return;
+
+    case Operation::kLoadRegistersFromMemory:
+      for_each_lane([&](size_t lane) {
+        const uint8_t* memory{ Memory(lane) };
+        for (size_t i = 0; i <= x; ++i) {
+          Registers(i)[lane] = memory[(index[lane] + i) & kAddressMask];
+        }
+      });
+      return;
+
+    case Operation::kSetDelayTimer2Vx:
+      for_each_lane([&](size_t lane) { vx[lane] = delay_timer_[lane]; });
+      return;
+
+    case Operation::kSetDelayTimer:
+      for_each_lane([&](size_t lane) { delay_timer_[lane] = vx[lane]; });
+      return;
+
+    case Operation::kSetSoundTimer:
+      for_each_lane([&](size_t lane) { sound_timer_[lane] = vx[lane]; });
+      return;
+
+    case Operation::kUnknown:
+      throw std::invalid_argument{ "unknown opcode" };
+  }
+};
+
+void LockstepEngine::OnTimersTick() {
+  while (cycles_ >= next_timer_tick_cycle_) {
+    ++timer_ticks_;
+    next_timer_tick_cycle_ = NextTimerTickCycle();
+
+    for (size_t lane = 0; lane < lanes_; ++lane) {
+      delay_timer_[lane] -= delay_timer_[lane] > 0;
+      sound_timer_[lane] -= sound_timer_[lane] > 0;
+    }
+  }
+};
+
+uint64_t LockstepEngine::NextTimerTickCycle() const {
+  return ((timer_ticks_ + 1) * clock_speed_ + Emulator::kChip8TimerFrequency - 1) /
+         Emulator::kChip8TimerFrequency;
+};
+
+}  // namespace chip8
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+#include "machine_state.h"
+#include "random.h"
+
+namespace chip8 {
+
+// Steps many copies of the same program in lockstep, with the quirks of Emulator (kModernQuirks). State is
+// kept as structure of arrays, one contiguous lane array per register, so an instruction shared by a group of
+// lanes runs as a single loop over lanes that the compiler vectorizes for the target (SSE/AVX2/AVX-512,
+// NEON).
+//
+// Every cycle in which all lanes are about to execute the same instruction, it runs once over all of them.
+// Otherwise lanes are sorted into groups by program counter and opcode, and each group executes its
+// instruction over its own list of lane indices while the other lanes keep their state. Lanes that diverge
+// therefore only cost one extra group per distinct instruction, not a pass over every lane per group, and
+// every lane always executes exactly one instruction per cycle, so the result is bit-identical to running a
+// scalar Emulator per lane with the same seed and a MemoryKeyboard holding the same keys.
+class LockstepEngine {
+ public:
+  // Lane N draws random numbers as an Emulator seeded with `seed` + N.
+  explicit LockstepEngine(const std::string& filename, size_t lanes, uint64_t seed = 0,
+                          uint32_t clock_speed = Emulator::kChip8DefaultClockSpeed);
+  // Every lane starts from `initial`, including its random state. Throws std::invalid_argument if `initial`
+  // is at high resolution, which kModernQuirks never switches to.
+  explicit LockstepEngine(const MachineState& initial, size_t lanes,
+                          uint32_t clock_speed = Emulator::kChip8DefaultClockSpeed);
+
+  size_t Lanes() const { return lanes_; }
+  uint64_t Cycles() const { return cycles_; }
+
+  // Keypad of `lane`, bit N is key N.
+  void SetKeys(size_t lane, uint16_t keys) { keys_[lane] = keys; }
+
+  // Executes one instruction in every lane followed by a timers tick if one is due.
+  void Step();
+
+  // Executes instructions up to and including the next 60 Hz timers tick.
+  void RunFrame();
+
+  MachineState CaptureState(size_t lane) const;
+
+ private:
+  // Executes `opcode` in `group`, lane indices in increasing order.
+  void Execute(uint16_t opcode, std::span<const uint32_t> group);
+  void ExecuteGroups();
+  void OnTimersTick();
+  uint64_t NextTimerTickCycle() const;
+
+  uint8_t* Registers(uint8_t x) { return &registers_[x * lanes_]; }
+  uint8_t* Memory(size_t lane) { return &memory_[lane * Emulator::kChip8MemorySize]; }
+  const uint8_t* Memory(size_t lane) const { return &memory_[lane * Emulator::kChip8MemorySize]; }
+  uint16_t OpcodeAt(size_t lane, uint16_t address) const;
+  void ResolveKeyWait(size_t lane);
+
+  static inline const uint8_t kNotWaiting{ 0xFF };
+
+  size_t lanes_;
+
+  // Indexed [register * lanes_ + lane], [row * lanes_ + lane] and [lane * memory size + address].
+  std::vector<uint8_t> registers_;
+  std::vector<uint16_t> stack_;
+  std::vector<uint8_t> stack_pointer_;
+  std::vector<uint16_t> program_counter_;
+  std::vector<uint16_t> index_register_;
+  std::vector<uint8_t> delay_timer_;
+  std::vector<uint8_t> sound_timer_;
+  std::vector<uint64_t> framebuffer_;
+  std::vector<uint8_t> memory_;
+  std::vector<uint16_t> keys_;
+  std::vector<Random> randoms_;
+  // Register FX0A stores the next key into for each waiting lane, kNotWaiting for the others.
+  std::vector<uint8_t> key_wait_;
+
+  // Lanes executing this cycle, the lanes of each sorted by `<pc><opcode><lane>` when they diverge, and the
+  // lanes of the group executing.
+  std::vector<uint32_t> executing_;
+  std::vector<uint64_t> instructions_;
+  std::vector<uint32_t> group_;
+
+  uint64_t cycles_{ 0 };
+  uint64_t timer_ticks_{ 0 };
+  uint64_t next_timer_tick_cycle_{ 0 };
+  uint32_t clock_speed_;
+};
+
+}  // namespace chip8
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "framebuffer.h"
+#include "random.h"
+
+namespace chip8 {
+
+// Architectural state of one chip8 machine, independent of the engine that produced it. Two engines agree
+// on a program exactly when their states compare equal after the same number of cycles.
+struct MachineState {
+  std::array<uint8_t, 16> variable_registers{};
+  std::array<uint16_t, 16> stack{};
+  uint8_t stack_pointer{ 0 };
+  uint16_t program_counter{ 0 };
+  uint16_t index_register{ 0 };
+  uint8_t delay_timer{ 0 };
+  uint8_t sound_timer{ 0 };
+  std::array<uint8_t, 4096> memory{};
+  Framebuffer framebuffer{};
+  Random::State random_state{};
+  // Register FX0A stores the next key into while the machine waits for one.
+  std::optional<uint8_t> key_wait_register{};
+
+  bool operator==(const MachineState&) const = default;
+};
+
+}  // namespace chip8
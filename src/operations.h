@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace chip8 {
+
+// Instruction classes shared by every execution engine. Keep in sync with kOperationNames and with
+// CHIP8_OPERATIONS in emulator.cc, which is checked at compile time.
+enum class Operation : uint8_t {
+  kIgnore,
+  kClearScreen,
+  kReturnFromSubroutine,
+  kScrollDown,
+  kScrollRight,
+  kScrollLeft,
+  kLowResolution,
+  kHighResolution,
+  kJump,
+  kCallSubroutine,
+  kSkipInstructionIfVxEqual,
+  kSkipInstructionIfVxNotEqual,
+  kSkipInstructionIfVxEqualVy,
+  kSetRegisterVx,
+  kAddToRegisterVx,
+  kSetVy2Vx,
+  kVxBinaryOrVy,
+  kVxBinaryAndVy,
+  kVxBinaryXorVy,
+  kAddVy2Vx,
+  kVxSubtractVy,
+  kShiftVxRight,
+  kVySubtractVx,
+  kShiftVxLeft,
+  kSkipInstructionIfVxNotEqualVy,
+  kSetIndexRegister,
+  kJumpWithOffset,
+  kVxBinaryAndRandom,
+  kDisplay,
+  kSkipInstructionIfPressed,
+  kSkipInstructionIfNotPressed,
+  kAddVx2IndexRegister,
+  kWaitForKeyPress,
+  kSetIndexRegisterForFont,
+  kHexInVxToDecimal,
+  kStoreRegistersInMemory,
+  kLoadRegistersFromMemory,
+  kSetDelayTimer2Vx,
+  kSetDelayTimer,
+  kSetSoundTimer,
+  kUnknown,
+};
+
+// Name of each operation, for profiles and diagnostics.
+inline constexpr std::array<std::string_view, static_cast<size_t>(Operation::kUnknown) + 1> kOperationNames{
+  "Ignore", "ClearScreen", "ReturnFromSubroutine", "ScrollDown", "ScrollRight", "ScrollLeft",
+  "LowResolution", "HighResolution", "Jump", "CallSubroutine", "SkipInstructionIfVxEqual",
+  "SkipInstructionIfVxNotEqual", "SkipInstructionIfVxEqualVy", "SetRegisterVx", "AddToRegisterVx", "SetVy2Vx",
+  "VxBinaryOrVy", "VxBinaryAndVy", "VxBinaryXorVy", "AddVy2Vx", "VxSubtractVy", "ShiftVxRight",
+  "VySubtractVx", "ShiftVxLeft", "SkipInstructionIfVxNotEqualVy", "SetIndexRegister", "JumpWithOffset",
+  "VxBinaryAndRandom", "Display", "SkipInstructionIfPressed", "SkipInstructionIfNotPressed",
+  "AddVx2IndexRegister", "WaitForKeyPress", "SetIndexRegisterForFont", "HexInVxToDecimal",
+  "StoreRegistersInMemory", "LoadRegistersFromMemory", "SetDelayTimer2Vx", "SetDelayTimer", "SetSoundTimer",
+  "Unknown"
+};
+
+// Maps a raw opcode to its operation, matching the nested switch in Emulator::Execute.
+constexpr Operation ClassifyOpcode(uint16_t raw) {
+  const uint8_t x{ static_cast<uint8_t>(raw >> 12) };
+  const uint8_t nn{ static_cast<uint8_t>(raw & 0x00FF) };
+  const uint8_t n{ static_cast<uint8_t>(raw & 0x000F) };
+
+  switch (x) {
+    case 0x0:
+      if ((raw & 0x0F00) == 0) {
+        if ((nn >> 4) == 0xC) return Operation::kScrollDown;
+        if (nn == 0xFB) return Operation::kScrollRight;
+        if (nn == 0xFC) return Operation::kScrollLeft;
+        if (nn == 0xFE) return Operation::kLowResolution;
+        if (nn == 0xFF) return Operation::kHighResolution;
+      }
+      if ((nn >> 4) != 0xE) return Operation::kIgnore;
+      if (n == 0x0) return Operation::kClearScreen;
+      if (n == 0xE) return Operation::kReturnFromSubroutine;
+      return Operation::kUnknown;
+    case 0x1:
+      return Operation::kJump;
+    case 0x2:
+      return Operation::kCallSubroutine;
+    case 0x3:
+      return Operation::kSkipInstructionIfVxEqual;
+    case 0x4:
+      return Operation::kSkipInstructionIfVxNotEqual;
+    case 0x5:
+      return Operation::kSkipInstructionIfVxEqualVy;
+    case 0x6:
+      return Operation::kSetRegisterVx;
+    case 0x7:
+      return Operation::kAddToRegisterVx;
+    case 0x8:
+      switch (n) {
+        case 0x0:
+          return Operation::kSetVy2Vx;
+        case 0x1:
+          return Operation::kVxBinaryOrVy;
+        case 0x2:
+          return Operation::kVxBinaryAndVy;
+        case 0x3:
+          return Operation::kVxBinaryXorVy;
+        case 0x4:
+          return Operation::kAddVy2Vx;
+        case 0x5:
+          return Operation::kVxSubtractVy;
+        case 0x6:
+          return Operation::kShiftVxRight;
+        case 0x7:
+          return Operation::kVySubtractVx;
+        case 0xE:
+          return Operation::kShiftVxLeft;
+        default:
+          return Operation::kUnknown;
+      }
+    case 0x9:
+      return Operation::kSkipInstructionIfVxNotEqualVy;
+    case 0xA:
+      return Operation::kSetIndexRegister;
+    case 0xB:
+      return Operation::kJumpWithOffset;
+    case 0xC:
+      return Operation::kVxBinaryAndRandom;
+    case 0xD:
+      return Operation::kDisplay;
+    case 0xE:
+      if (nn == 0x9E) return Operation::kSkipInstructionIfPressed;
+      if (nn == 0xA1) return Operation::kSkipInstructionIfNotPressed;
+      return Operation::kUnknown;
+    default:
+      switch (nn) {
+        case 0x1E:
+          return Operation::kAddVx2IndexRegister;
+        case 0x0A:
+          return Operation::kWaitForKeyPress;
+        case 0x29:
+          return Operation::kSetIndexRegisterForFont;
+        case 0x33:
+          return Operation::kHexInVxToDecimal;
+        case 0x55:
+          return Operation::kStoreRegistersInMemory;
+        case 0x65:
+          return Operation::kLoadRegistersFromMemory;
+        case 0x07:
+          return Operation::kSetDelayTimer2Vx;
+        case 0x15:
+          return Operation::kSetDelayTimer;
+        case 0x18:
+          return Operation::kSetSoundTimer;
+        default:
+          return Operation::kUnknown;
+      }
+  }
+}
+
+// Whether execution may continue anywhere but the next instruction, or the instruction writes memory that
+// a translated block could cover.
+constexpr bool EndsBasicBlock(Operation operation) {
+  switch (operation) {
+    case Operation::kReturnFromSubroutine:
+    case Operation::kJump:
+    case Operation::kCallSubroutine:
+    case Operation::kSkipInstructionIfVxEqual:
+    case Operation::kSkipInstructionIfVxNotEqual:
+    case Operation::kSkipInstructionIfVxEqualVy:
+    case Operation::kSkipInstructionIfVxNotEqualVy:
+    case Operation::kJumpWithOffset:
+    case Operation::kSkipInstructionIfPressed:
+    case Operation::kSkipInstructionIfNotPressed:
+    case Operation::kWaitForKeyPress:
+    case Operation::kHexInVxToDecimal:
+    case Operation::kStoreRegistersInMemory:
+    case Operation::kUnknown:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Operation of every possible 16-bit opcode, computed at compile time.
+inline constexpr std::array<Operation, 0x10000> kOperationTable{ [] {
+  std::array<Operation, 0x10000> table{};
+  for (size_t raw = 0; raw < table.size(); ++raw) {
+    table[raw] = ClassifyOpcode(static_cast<uint16_t>(raw));
+  }
+  return table;
+}() };
+
+}  // namespace chip8
@@ -0,0 +1,52 @@
+#include "paged_memory.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace chip8 {
+
+namespace {
+
+const std::shared_ptr<PagedMemory::Page>& ZeroPage() {
+  static const std::shared_ptr<PagedMemory::Page> page{ std::make_shared<PagedMemory::Page>() };
+  return page;
+}
+
+}  // namespace
+
+PagedMemory::PagedMemory() {
+  pages_.fill(ZeroPage());
+};
+
+size_t PagedMemory::PrivatePages() const {
+  return std::count_if(pages_.begin(), pages_.end(), [](const auto& page) { return page.use_count() == 1; });
+};
+
+std::array<uint8_t, PagedMemory::kSize> PagedMemory::Contents() const {
+  std::array<uint8_t, kSize> contents;
+  for (size_t page = 0; page < kPageCount; ++page) {
+    std::copy(pages_[page]->begin(), pages_[page]->end(), contents.begin() + page * kPageSize);
+  }
+  return contents;
+};
+
+void PagedMemory::Assign(const std::array<uint8_t, kSize>& contents) {
+  for (size_t page = 0; page < kPageCount; ++page) {
+    const auto first{ contents.begin() + page * kPageSize };
+    if (std::equal(first, first + kPageSize, pages_[page]->begin())) continue;
+
+    auto replacement{ std::make_shared<Page>() };
+    std::copy(first, first + kPageSize, replacement->begin());
+    pages_[page] = std::move(replacement);
+  }
+};
+
+void PagedMemory::MakePrivate(size_t page) {
+  pages_[page] = std::make_shared<Page>(*pages_[page]);
+};
+
+}  // namespace chip8
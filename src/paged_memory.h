@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace chip8 {
+
+// The 4 KB chip8 address space split into 256-byte pages shared copy-on-write. Copying a PagedMemory only
+// shares its pages, and a page is duplicated the first time one of its owners writes to it, so instances
+// cloned from one parent only pay for the pages they actually modify. Pages that were never written all
+// share one zero page.
+//
+// Addresses wrap around the end of memory.
+class PagedMemory {
+ public:
+  static inline const uint16_t kSize{ 4096 };
+  static inline const uint16_t kPageSize{ 256 };
+  static inline const size_t kPageCount{ kSize / kPageSize };
+
+  using Page = std::array<uint8_t, kPageSize>;
+
+  PagedMemory();
+
+  uint8_t operator[](uint16_t address) const {
+    address &= kSize - 1;
+    return (*pages_[address / kPageSize])[address % kPageSize];
+  }
+
+  void Write(uint16_t address, uint8_t value) {
+    address &= kSize - 1;
+    std::shared_ptr<Page>& page{ pages_[address / kPageSize] };
+    if (page.use_count() != 1) {
+      MakePrivate(address / kPageSize);
+    } else {
+      // Pairs with the release of the last other owner so its reads of the page happen before this write.
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    (*page)[address % kPageSize] = value;
+  }
+
+  // Number of pages this instance does not share with any other.
+  size_t PrivatePages() const;
+
+  const Page& GetPage(size_t page) const { return *pages_[page]; }
+
+  std::array<uint8_t, kSize> Contents() const;
+
+  // Replaces the whole contents. Pages whose contents do not change stay shared.
+  void Assign(const std::array<uint8_t, kSize>& contents);
+
+ private:
+  void MakePrivate(size_t page);
+
+  std::array<std::shared_ptr<Page>, kPageCount> pages_;
+};
+
+}  // namespace chip8
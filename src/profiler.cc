@@ -0,0 +1,90 @@
+#include "profiler.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "operations.h"
+
+namespace chip8 {
+
+namespace {
+
+// Indices of the nonzero entries of `counts`, most frequent first, at most `limit` of them.
+template <size_t N>
+std::vector<size_t> TopEntries(const std::array<uint64_t, N>& counts, size_t limit) {
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    if (counts[i] != 0) indices.push_back(i);
+  }
+  const size_t kept{ std::min(limit, indices.size()) };
+  std::partial_sort(indices.begin(), indices.begin() + kept, indices.end(), [&](size_t a, size_t b) {
+    return counts[a] > counts[b] || (counts[a] == counts[b] && a < b);
+  });
+  indices.resize(kept);
+  return indices;
+}
+
+double Percent(uint64_t part, uint64_t whole) { return whole == 0 ? 0.0 : 100.0 * part / whole; }
+
+}  // namespace
+
+uint64_t Profile::Instructions() const {
+  return std::accumulate(operations.begin(), operations.end(), uint64_t{ 0 });
+};
+
+std::string ProfileToJson(const Profile& profile, size_t hot_pcs) {
+  std::string json{ fmt::format("{{\"instructions\":{},\"operations\":{{", profile.Instructions()) };
+  bool first{ true };
+  for (size_t operation = 0; operation < profile.operations.size(); ++operation) {
+    if (profile.operations[operation] == 0) continue;
+    json += fmt::format("{}\"{}\":{}", first ? "" : ",", kOperationNames[operation],
+                        profile.operations[operation]);
+    first = false;
+  }
+
+  const size_t distinct_pcs{ static_cast<size_t>(std::count_if(profile.pc_hits.begin(), profile.pc_hits.end(),
+                                                                [](uint64_t hits) { return hits != 0; })) };
+  json += fmt::format(
+      "}},\"sprite_rows\":{},\"collisions\":{},\"presents\":{},\"memory_writes\":{},\"code_writes\":{},"
+      "\"timer_ticks\":{},\"delay_ticks\":{},\"sound_ticks\":{},\"key_wait_cycles\":{},\"distinct_pcs\":{},"
+      "\"hot_pcs\":[",
+      profile.sprite_rows, profile.collisions, profile.presents, profile.memory_writes, profile.code_writes,
+      profile.timer_ticks, profile.delay_ticks, profile.sound_ticks, profile.key_wait_cycles, distinct_pcs);
+  first = true;
+  for (size_t address : TopEntries(profile.pc_hits, hot_pcs)) {
+    json += fmt::format("{}{{\"pc\":{},\"hits\":{}}}", first ? "" : ",", address, profile.pc_hits[address]);
+    first = false;
+  }
+  json += "]}";
+  return json;
+};
+
+void LogProfile(const Profile& profile, size_t hot_pcs) {
+  const uint64_t instructions{ profile.Instructions() };
+  spdlog::info("profile: {} instructions, {} frames presented, {} sprite rows drawn, {} collisions",
+               instructions, profile.presents, profile.sprite_rows, profile.collisions);
+  spdlog::info("profile: {} timer ticks, delay timer running on {}, sound timer on {}", profile.timer_ticks,
+               profile.delay_ticks, profile.sound_ticks);
+  spdlog::info("profile: {} cycles waiting for a key", profile.key_wait_cycles);
+  spdlog::info("profile: {} memory writes, {} of them to executed code", profile.memory_writes,
+               profile.code_writes);
+
+  for (size_t operation : TopEntries(profile.operations, profile.operations.size())) {
+    spdlog::info("profile: {:>30} {:>12} {:5.1f}%", kOperationNames[operation], profile.operations[operation],
+                 Percent(profile.operations[operation], instructions));
+  }
+  for (size_t address : TopEntries(profile.pc_hits, hot_pcs)) {
+    spdlog::info("profile: hot pc {:#05x} {:>12} {:5.1f}%", address, profile.pc_hits[address],
+                 Percent(profile.pc_hits[address], instructions));
+  }
+};
+
+}  // namespace chip8
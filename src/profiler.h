@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "operations.h"
+
+// Execution statistics are only gathered when the core is built with the CHIP8_PROFILE CMake option.
+// Otherwise CHIP8_PROFILE_HOOK drops its argument, Emulator has no Profile member and the hooks cost
+// nothing at all.
+#if defined(CHIP8_PROFILE)
+#define CHIP8_PROFILE_HOOK(...) __VA_ARGS__
+#else
+#define CHIP8_PROFILE_HOOK(...)
+#endif
+
+namespace chip8 {
+
+// What one emulator instance spent its time on. Comparing the Display share and sprite rows against the
+// instruction count tells a ROM bound on drawing from one bound on dispatch, and the PC histogram and code
+// writes tell how much predecoding or translating it would pay off.
+struct Profile {
+  static inline const size_t kAddresses{ 4096 };
+
+  // Instructions executed per operation, indexed by Operation.
+  std::array<uint64_t, kOperationNames.size()> operations{};
+  // Instructions fetched from each address.
+  std::array<uint64_t, kAddresses> pc_hits{};
+  // Rows of sprite data XORed onto the framebuffer, and Display calls that erased a pixel.
+  uint64_t sprite_rows{ 0 };
+  uint64_t collisions{ 0 };
+  // Frames actually drawn to the screen; unchanged frames are not presented.
+  uint64_t presents{ 0 };
+  // Memory writes, and those that hit an address already executed, i.e. self-modifying code.
+  uint64_t memory_writes{ 0 };
+  uint64_t code_writes{ 0 };
+  // 60 Hz timer ticks, those on which the delay or sound timer was running, and cycles spent in FX0A
+  // waiting for a key.
+  uint64_t timer_ticks{ 0 };
+  uint64_t delay_ticks{ 0 };
+  uint64_t sound_ticks{ 0 };
+  uint64_t key_wait_cycles{ 0 };
+
+  void CountInstruction(uint16_t address, Operation operation) {
+    ++operations[static_cast<size_t>(operation)];
+    ++pc_hits[address & (kAddresses - 1)];
+  }
+
+  void CountWrite(uint16_t address) {
+    ++memory_writes;
+    // Either byte of an instruction counts as code.
+    if (pc_hits[address & (kAddresses - 1)] != 0 || pc_hits[(address - 1) & (kAddresses - 1)] != 0) {
+      ++code_writes;
+    }
+  }
+
+  void CountTimerTick(uint8_t delay_timer, uint8_t sound_timer) {
+    ++timer_ticks;
+    if (delay_timer > 0) ++delay_ticks;
+    if (sound_timer > 0) ++sound_ticks;
+  }
+
+  uint64_t Instructions() const;
+};
+
+// Renders `profile` as a single line of JSON. Only the `hot_pcs` most executed addresses are listed.
+std::string ProfileToJson(const Profile& profile, size_t hot_pcs = 16);
+
+// Logs a human readable summary through spdlog.
+void LogProfile(const Profile& profile, size_t hot_pcs = 8);
+
+}  // namespace chip8
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdexcept>
+#include <string_view>
+
+namespace chip8 {
+
+// Behaviours in which CHIP-8 interpreters disagree. A Quirks value is a template argument of BasicEmulator,
+// so every profile is a separately compiled core whose quirks are resolved with `if constexpr` and never
+// tested at run time.
+struct Quirks {
+  // 8XY6 and 8XYE shift Vy into Vx, instead of shifting Vx in place.
+  bool shift_reads_vy;
+  // BNNN jumps to NNN plus VX, X being the top nibble of NNN, instead of NNN plus V0.
+  bool jump_reads_vx;
+  // FX55 and FX65 leave I pointing just past the last register transferred.
+  bool load_store_advances_index;
+  // 8XY1, 8XY2 and 8XY3 clear VF.
+  bool logic_clears_vf;
+  // Sprites crossing an edge of the screen wrap around to the opposite edge, instead of being clipped.
+  bool sprites_wrap;
+  // The SUPER-CHIP display: 00FE and 00FF switch between 64x32 and 128x64, 00CN, 00FB and 00FC scroll, and
+  // DXY0 draws a 16x16 sprite. Without it those are ignored like any other 0NNN, and DXY0 draws nothing.
+  bool extended_display;
+
+  bool operator==(const Quirks&) const = default;
+};
+
+// What most modern ROMs are written against, and what the core has always done.
+inline constexpr Quirks kModernQuirks{
+  .shift_reads_vy = false,
+  .jump_reads_vx = false,
+  .load_store_advances_index = false,
+  .logic_clears_vf = false,
+  .sprites_wrap = false,
+  .extended_display = false,
+};
+
+// The original interpreter on the COSMAC VIP.
+inline constexpr Quirks kCosmacVipQuirks{
+  .shift_reads_vy = true,
+  .jump_reads_vx = false,
+  .load_store_advances_index = true,
+  .logic_clears_vf = true,
+  .sprites_wrap = false,
+  .extended_display = false,
+};
+
+// CHIP-48 and SUPER-CHIP on HP calculators.
+inline constexpr Quirks kSuperChipQuirks{
+  .shift_reads_vy = false,
+  .jump_reads_vx = true,
+  .load_store_advances_index = false,
+  .logic_clears_vf = false,
+  .sprites_wrap = false,
+  .extended_display = true,
+};
+
+// XO-CHIP, as implemented by Octo.
+inline constexpr Quirks kXoChipQuirks{
+  .shift_reads_vy = true,
+  .jump_reads_vx = false,
+  .load_store_advances_index = true,
+  .logic_clears_vf = false,
+  .sprites_wrap = true,
+  .extended_display = true,
+};
+
+// Every profile with its name on the command line. The core is explicitly instantiated once per entry.
+#define CHIP8_QUIRK_PROFILES(PROFILE) \
+  PROFILE(kModernQuirks, "modern")    \
+  PROFILE(kCosmacVipQuirks, "vip")    \
+  PROFILE(kSuperChipQuirks, "schip")  \
+  PROFILE(kXoChipQuirks, "xochip")
+
+// Names a profile as a type, so one generic lambda can be written against all of them.
+template <Quirks kProfile>
+struct QuirksProfile {
+  static constexpr Quirks kQuirks{ kProfile };
+};
+
+// Calls `visitor(QuirksProfile<profile>{})` for the profile called `name`, picking the instantiation a host
+// runs at startup. Throws std::invalid_argument for an unknown name.
+template <typename Visitor>
+void VisitQuirksProfile(std::string_view name, Visitor&& visitor) {
+#define CHIP8_VISIT_QUIRKS_PROFILE(profile, label) \
+  if (name == label) return visitor(QuirksProfile<profile>{});
+  CHIP8_QUIRK_PROFILES(CHIP8_VISIT_QUIRKS_PROFILE)
+#undef CHIP8_VISIT_QUIRKS_PROFILE
+  throw std::invalid_argument{ "unknown quirks profile, expected modern, vip, schip or xochip" };
+}
+
+}  // namespace chip8
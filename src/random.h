@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace chip8 {
+
+// xoshiro128** generator. Small enough to live in every emulator instance and in its save state, so
+// instances never share random state and a run is reproducible from its seed alone.
+class Random {
+ public:
+  using State = std::array<uint32_t, 4>;
+
+  explicit Random(uint64_t seed = 0) { Seed(seed); }
+
+  // Expands `seed` with splitmix64, so nearby seeds still give unrelated sequences.
+  void Seed(uint64_t seed) {
+    for (size_t i = 0; i < state_.size(); i += 2) {
+      seed += 0x9E3779B97F4A7C15;
+      uint64_t z{ seed };
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+      z ^= z >> 31;
+      state_[i] = static_cast<uint32_t>(z);
+      state_[i + 1] = static_cast<uint32_t>(z >> 32);
+    }
+  }
+
+  uint32_t Next() {
+    const uint32_t result{ Rotl(state_[1] * 5, 7) * 9 };
+    const uint32_t t{ state_[1] << 9 };
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = Rotl(state_[3], 11);
+    return result;
+  }
+
+  // The high bits are the best distributed ones.
+  uint8_t NextByte() { return static_cast<uint8_t>(Next() >> 24); }
+
+  const State& GetState() const { return state_; }
+  void SetState(const State& state) { state_ = state; }
+
+  bool operator==(const Random&) const = default;
+
+ private:
+  static uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+  State state_{};
+};
+
+}  // namespace chip8
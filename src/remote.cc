@@ -0,0 +1,294 @@
+#include "remote.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+
+namespace chip8 {
+
+namespace {
+
+// Bytes of a row in the order the protocol numbers them, 8 at low and 16 at high resolution.
+std::array<uint8_t, 16> RowBytes(const Framebuffer& framebuffer, size_t y) {
+  std::array<uint8_t, 16> bytes{};
+  for (size_t i = 0; i < 8; ++i) {
+    bytes[i] = static_cast<uint8_t>(framebuffer.left[y] >> (56 - 8 * i));
+    bytes[i + 8] = static_cast<uint8_t>(framebuffer.right[y] >> (56 - 8 * i));
+  }
+  return bytes;
+}
+
+size_t RowSize(bool hires) { return hires ? 16 : 8; }
+
+void AppendLeb128(std::vector<uint8_t>& out, uint64_t value) {
+  do {
+    out.push_back(static_cast<uint8_t>((value & 0x7F) | (value > 0x7F ? 0x80 : 0)));
+    value >>= 7;
+  } while (value != 0);
+}
+
+// Appends the rows record turning `previous` into `current`, if the client would see any difference.
+void AppendRows(std::vector<uint8_t>& out, const Framebuffer& previous, const Framebuffer& current) {
+  const bool resized{ previous.hires != current.hires };
+  const Framebuffer blank{ .hires = current.hires };
+  const Framebuffer& base{ resized ? blank : previous };
+
+  std::optional<size_t> first;
+  size_t last{ 0 };
+  for (size_t y = 0; y < current.Height(); ++y) {
+    if (current.left[y] == base.left[y] && current.right[y] == base.right[y]) continue;
+    if (!first.has_value()) first = y;
+    last = y;
+  }
+  if (!first.has_value() && !resized) return;
+
+  out.push_back(current.hires ? kRemoteHighResRows : kRemoteLowResRows);
+  if (!first.has_value()) return;
+
+  out.push_back(static_cast<uint8_t>(*first));
+  out.push_back(static_cast<uint8_t>(last));
+  const size_t rows_mask{ out.size() };
+  out.resize(out.size() + (last - *first) / 8 + 1, 0);
+  for (size_t y = *first; y <= last; ++y) {
+    if (current.left[y] == base.left[y] && current.right[y] == base.right[y]) continue;
+    out[rows_mask + (y - *first) / 8] |= static_cast<uint8_t>(1 << ((y - *first) % 8));
+
+    const std::array<uint8_t, 16> before{ RowBytes(base, y) };
+    const std::array<uint8_t, 16> after{ RowBytes(current, y) };
+    uint16_t mask{ 0 };
+    for (size_t i = 0; i < RowSize(current.hires); ++i) {
+      if (before[i] != after[i]) mask |= static_cast<uint16_t>(1 << i);
+    }
+    out.push_back(static_cast<uint8_t>(mask & 0xFF));
+    if (current.hires) out.push_back(static_cast<uint8_t>(mask >> 8));
+    for (size_t i = 0; i < RowSize(current.hires); ++i) {
+      if (before[i] != after[i]) out.push_back(before[i] ^ after[i]);
+    }
+  }
+}
+
+// Reads the records of one message, throwing once it runs past the end.
+class Reader {
+ public:
+  explicit Reader(std::span<const uint8_t> bytes) : bytes_{ bytes } {};
+
+  bool AtEnd() const { return offset_ == bytes_.size(); }
+
+  uint8_t Byte() {
+    if (AtEnd()) {
+      throw std::invalid_argument{ "truncated remote message" };
+    }
+    return bytes_[offset_++];
+  }
+
+ private:
+  std::span<const uint8_t> bytes_;
+  size_t offset_{ 0 };
+};
+
+}  // namespace
+
+void RemoteFrameEncoder::Encode(const Framebuffer& framebuffer, std::optional<uint8_t> beep,
+                                std::vector<uint8_t>& out) {
+  records_.clear();
+  if (beep.has_value()) {
+    records_.push_back(kRemoteSound);
+    records_.push_back(*beep);
+  }
+  AppendRows(records_, sent_, framebuffer);
+  sent_ = framebuffer;
+  if (records_.empty()) return;
+
+  AppendLeb128(out, records_.size());
+  out.insert(out.end(), records_.begin(), records_.end());
+};
+
+size_t RemoteFrameDecoder::Decode(std::span<const uint8_t> bytes) {
+  uint64_t length{ 0 };
+  size_t header{ 0 };
+  for (int shift = 0;; shift += 7) {
+    if (header == bytes.size()) return 0;
+    if (shift >= 28) {
+      throw std::invalid_argument{ "malformed remote message length" };
+    }
+    const uint8_t byte{ bytes[header++] };
+    length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) break;
+  }
+  if (bytes.size() - header < length) return 0;
+
+  beep_.reset();
+  Reader reader{ bytes.subspan(header, length) };
+  while (!reader.AtEnd()) {
+    const uint8_t tag{ reader.Byte() };
+    if (tag == kRemoteSound) {
+      beep_ = reader.Byte();
+      continue;
+    }
+    if (tag != kRemoteLowResRows && tag != kRemoteHighResRows) {
+      throw std::invalid_argument{ "unknown remote record" };
+    }
+
+    const bool hires{ tag == kRemoteHighResRows };
+    if (hires != frame_.hires) {
+      frame_ = Framebuffer{ .hires = hires };
+    }
+    // A rows record ends its message, so one that is only the tag is the whole rest of it.
+    if (reader.AtEnd()) break;
+
+    const uint8_t first{ reader.Byte() };
+    const uint8_t last{ reader.Byte() };
+    if (first > last || last >= frame_.Height()) {
+      throw std::invalid_argument{ "remote rows out of range" };
+    }
+    std::array<uint8_t, kFramebufferHeight / 8> rows{};
+    for (size_t i = 0; i <= (last - first) / 8u; ++i) {
+      rows[i] = reader.Byte();
+    }
+    for (size_t y = first; y <= last; ++y) {
+      if (((rows[(y - first) / 8] >> ((y - first) % 8)) & 1) == 0) continue;
+
+      uint16_t mask{ reader.Byte() };
+      if (hires) mask |= static_cast<uint16_t>(reader.Byte() << 8);
+      for (size_t i = 0; i < RowSize(hires); ++i) {
+        if (((mask >> i) & 1) == 0) continue;
+        uint64_t& word{ i < 8 ? frame_.left[y] : frame_.right[y] };
+        word ^= static_cast<uint64_t>(reader.Byte()) << (56 - 8 * (i % 8));
+      }
+    }
+  }
+  return header + length;
+};
+
+RemoteScreen::RemoteScreen(uint16_t port) {
+  listener_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listener_ < 0) {
+    throw std::runtime_error{ "Error creating remote screen socket" };
+  }
+
+  const int reuse{ 1 };
+  ::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (::bind(listener_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+      ::listen(listener_, 1) != 0) {
+    ::close(listener_);
+    throw std::runtime_error{ "Error listening on port " + std::to_string(port) };
+  }
+};
+
+uint16_t RemoteScreen::Port() const {
+  sockaddr_in address{};
+  socklen_t size{ sizeof(address) };
+  if (::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &size) != 0) {
+    throw std::runtime_error{ "Error reading remote screen port" };
+  }
+  return ntohs(address.sin_port);
+};
+
+RemoteScreen::~RemoteScreen() {
+  Disconnect();
+  ::close(listener_);
+};
+
+void RemoteScreen::Accept() {
+  do {
+    client_ = ::accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  } while (client_ < 0 && errno == EINTR);
+  if (client_ < 0) {
+    throw std::runtime_error{ "Error accepting remote screen client" };
+  }
+
+  // Every message is a whole frame, so there is nothing to gain from holding it back for more.
+  const int no_delay{ 1 };
+  ::setsockopt(client_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+};
+
+bool RemoteScreen::IsOpen() {
+  if (client_ < 0) return false;
+
+  Receive();
+  if (client_ >= 0) Flush();
+  return client_ >= 0;
+};
+
+void RemoteScreen::Draw(const Framebuffer& screen) { drawn_ = screen; };
+
+void RemoteScreen::Receive() {
+  std::array<uint8_t, 256> buffer;
+  while (true) {
+    const ssize_t received{ ::recv(client_, buffer.data(), buffer.size(), 0) };
+    if (received > 0) {
+      incoming_.insert(incoming_.end(), buffer.begin(), buffer.begin() + received);
+    } else if (received < 0 && errno == EINTR) {
+      continue;
+    } else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else {
+      Disconnect();
+      return;
+    }
+  }
+
+  // Only the newest state matters; an odd byte is the first half of one still in flight.
+  const size_t complete{ incoming_.size() & ~size_t{ 1 } };
+  if (complete == 0) return;
+  keys_.store(static_cast<uint16_t>(incoming_[complete - 2] | (incoming_[complete - 1] << 8)),
+              std::memory_order_relaxed);
+  incoming_.erase(incoming_.begin(), incoming_.begin() + complete);
+};
+
+void RemoteScreen::Flush() {
+  std::optional<uint8_t> beep;
+  if (const int ticks{ beep_.exchange(kNoBeep, std::memory_order_relaxed) }; ticks != kNoBeep) {
+    beep = static_cast<uint8_t>(ticks);
+  }
+  encoder_.Encode(drawn_, beep, outgoing_);
+
+  size_t offset{ 0 };
+  while (offset < outgoing_.size()) {
+    const ssize_t sent{ ::send(client_, outgoing_.data() + offset, outgoing_.size() - offset, MSG_NOSIGNAL) };
+    if (sent > 0) {
+      offset += static_cast<size_t>(sent);
+    } else if (sent < 0 && errno == EINTR) {
+      continue;
+    } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else {
+      Disconnect();
+      return;
+    }
+  }
+  bytes_sent_ += offset;
+  outgoing_.erase(outgoing_.begin(), outgoing_.begin() + offset);
+
+  if (outgoing_.size() > kMaxBacklog) {
+    Disconnect();
+  }
+};
+
+void RemoteScreen::Disconnect() {
+  if (client_ < 0) return;
+
+  ::close(client_);
+  client_ = -1;
+};
+
+}  // namespace chip8
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "framebuffer.h"
+#include "keyboard.h"
+#include "screen.h"
+#include "speaker.h"
+
+namespace chip8 {
+
+// Frontends that show and drive an emulator over a TCP connection, e.g. one running on a headless server.
+// They plug in where the SFML ones do: RemoteScreen is the window RunEmulationThread presents to, and
+// RemoteKeyboard and RemoteSpeaker hang off it like SfmlKeyboard hangs off SfmlScreen.
+//
+// Everything the client needs for a frame goes out as one message, and frames in which nothing changed send
+// nothing at all. A message is `<LEB128 length><records>`:
+//  - `kRemoteSound <ticks>`: the last load of the sound timer in the frame, with the meaning of
+//    Speaker::Beep.
+//  - `kRemoteLowResRows` or `kRemoteHighResRows`, always the last record of its message, then
+//    `<first row><last row>` of the rows that changed and a bitmask of which rows in that span did, one bit
+//    per row from the first, least significant bit first, padded to whole bytes. Each changed row follows in
+//    order as a mask of its changed bytes, one byte at low and two little endian bytes at high resolution,
+//    bit N standing for byte N of the row with the leftmost pixels in byte 0 and the most significant bit,
+//    then the XOR of every changed byte with its previous value. A record whose resolution differs from the
+//    previous one's is XORed with a blank frame and may change no rows at all, in which case it is only the
+//    tag. The first record's predecessor is a blank low resolution frame.
+// Sprites usually change a byte or two of a few neighbouring rows, so a typical frame costs about ten bytes
+// and a typical game, which leaves most frames alone, a few hundred bytes a second.
+//
+// The client sends the whole keypad state as a `<uint16 little endian>` with bit N for key N whenever it
+// changes; the last complete one received is the state the emulator latches.
+static inline const uint8_t kRemoteLowResRows{ 0x01 };
+static inline const uint8_t kRemoteHighResRows{ 0x02 };
+static inline const uint8_t kRemoteSound{ 0x03 };
+
+// Server side of the protocol.
+class RemoteFrameEncoder {
+ public:
+  // Appends the message taking the client from the previous frame to `framebuffer` and sounding `beep`, or
+  // nothing if the client would see no difference.
+  void Encode(const Framebuffer& framebuffer, std::optional<uint8_t> beep, std::vector<uint8_t>& out);
+
+ private:
+  Framebuffer sent_{};
+  std::vector<uint8_t> records_;
+};
+
+// Client side of the protocol.
+class RemoteFrameDecoder {
+ public:
+  // Applies the message at the front of `bytes` and returns its size, or 0 if it has not been received
+  // completely yet. Throws std::invalid_argument on a malformed message.
+  size_t Decode(std::span<const uint8_t> bytes);
+
+  const Framebuffer& Frame() const { return frame_; }
+  // Sound timer load of the last message, if it had one.
+  std::optional<uint8_t> Beep() const { return beep_; }
+
+ private:
+  Framebuffer frame_{};
+  std::optional<uint8_t> beep_;
+};
+
+class RemoteScreen : public Screen {
+ public:
+  // Listens on `port` on every interface, or on a port picked by the system if 0. Throws std::runtime_error
+  // if the socket cannot be set up.
+  explicit RemoteScreen(uint16_t port);
+  ~RemoteScreen() override;
+
+  RemoteScreen(const RemoteScreen&) = delete;
+  RemoteScreen& operator=(const RemoteScreen&) = delete;
+
+  // The port listened on.
+  uint16_t Port() const;
+
+  // Blocks until a client connects. A screen serves a single client.
+  void Accept();
+
+  // Receives keypad updates and sends the message of the frame drawn since the last call, so the client
+  // sees each frame when the screen is next pumped. Returns false once the client has disconnected or
+  // fallen too far behind.
+  bool IsOpen() override;
+
+  void Draw(const Framebuffer& screen) override;
+
+  // Either thread.
+  uint16_t Keys() const { return keys_.load(std::memory_order_relaxed); }
+  void QueueBeep(uint8_t ticks) { beep_.store(ticks, std::memory_order_relaxed); }
+
+  // Total sent to the client so far, for bandwidth accounting.
+  uint64_t BytesSent() const { return bytes_sent_; }
+
+ private:
+  // Unsent data the client may fall behind by before it is dropped, many seconds of a busy game.
+  static inline const size_t kMaxBacklog{ 64 * 1024 };
+  // Stored in `beep_` while no sound timer load is pending.
+  static inline const int kNoBeep{ -1 };
+
+  void Receive();
+  void Flush();
+  void Disconnect();
+
+  int listener_{ -1 };
+  int client_{ -1 };
+
+  RemoteFrameEncoder encoder_;
+  // Newest frame drawn.
+  Framebuffer drawn_{};
+
+  std::vector<uint8_t> outgoing_;
+  std::vector<uint8_t> incoming_;
+  uint64_t bytes_sent_{ 0 };
+
+  // Written by the thread pumping the screen, read by the emulation thread, and the other way around.
+  std::atomic<uint16_t> keys_{ 0 };
+  std::atomic<int> beep_{ kNoBeep };
+};
+
+// Keypad state as last sent by the client of `screen`.
+class RemoteKeyboard : public Keyboard {
+ public:
+  explicit RemoteKeyboard(RemoteScreen& screen) : screen_{ screen } {};
+
+  bool IsKeyPressed(uint8_t key) override { return (screen_.Keys() >> (key & 0xF)) & 1; }
+  uint16_t LatchKeys(uint64_t /*frame*/) override { return screen_.Keys(); }
+
+ private:
+  RemoteScreen& screen_;
+};
+
+// Forwards sound timer loads to the client of `screen` with the next frame's message.
+class RemoteSpeaker : public Speaker {
+ public:
+  explicit RemoteSpeaker(RemoteScreen& screen) : screen_{ screen } {};
+
+  void Beep(uint8_t ticks) override { screen_.QueueBeep(ticks); }
+
+ private:
+  RemoteScreen& screen_;
+};
+
+}  // namespace chip8
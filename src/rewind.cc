@@ -0,0 +1,141 @@
+#include "rewind.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "save_state.h"
+
+namespace chip8 {
+
+RewindBuffer::RewindBuffer(size_t capacity) : storage_(capacity) {
+  if (capacity == 0) {
+    throw std::invalid_argument{ "rewind buffer capacity must be positive" };
+  }
+};
+
+void RewindBuffer::Record(const SaveState& state) {
+  if (!newest_) {
+    newest_ = state;
+    return;
+  }
+
+  BeginFrame();
+  Update(0, state);
+  EndFrame();
+};
+
+void RewindBuffer::BeginFrame() {
+  if (!newest_) {
+    throw std::logic_error{ "rewind frame begun with no frame to build on" };
+  }
+  delta_.clear();
+  run_.reset();
+};
+
+void RewindBuffer::Update(size_t offset, std::span<const uint8_t> bytes) {
+  if (offset % kWordSize != 0 || bytes.size() % kWordSize != 0 || offset > sizeof(SaveState) ||
+      bytes.size() > sizeof(SaveState) - offset) {
+    throw std::invalid_argument{ "rewind frame part out of bounds or not whole words" };
+  }
+
+  uint8_t* newest{ reinterpret_cast<uint8_t*>(&*newest_) + offset };
+  for (size_t i = 0; i < bytes.size(); i += kWordSize) {
+    uint64_t current;
+    uint64_t previous;
+    std::memcpy(&current, bytes.data() + i, kWordSize);
+    std::memcpy(&previous, newest + i, kWordSize);
+    if (current == previous) continue;
+
+    const size_t word{ (offset + i) / kWordSize };
+    if (!run_.has_value() || run_end_ != word || delta_[*run_ + 2] == kMaxRunWords) {
+      run_ = delta_.size();
+      delta_.push_back(static_cast<uint8_t>(word & 0xFF));
+      delta_.push_back(static_cast<uint8_t>(word >> 8));
+      delta_.push_back(0);
+    }
+    const uint64_t change{ current ^ previous };
+    const size_t at{ delta_.size() };
+    delta_.resize(at + kWordSize);
+    std::memcpy(delta_.data() + at, &change, kWordSize);
+    ++delta_[*run_ + 2];
+    run_end_ = word + 1;
+    std::memcpy(newest + i, &current, kWordSize);
+  }
+};
+
+void RewindBuffer::EndFrame() { Store(delta_); };
+
+void RewindBuffer::Store(std::span<const uint8_t> delta) {
+  if (delta.size() > storage_.size()) {
+    // Cannot be undone within the capacity, so nothing recorded before it can be reached either.
+    entries_.clear();
+    write_offset_ = 0;
+    bytes_ = 0;
+    return;
+  }
+
+  if (write_offset_ + delta.size() > storage_.size()) {
+    // The tail of the storage is too short; the entries still in it are the oldest ones.
+    while (!entries_.empty() && entries_.front().offset >= write_offset_) {
+      DropOldest();
+    }
+    write_offset_ = 0;
+  }
+  while (!entries_.empty() && entries_.front().offset >= write_offset_ &&
+         entries_.front().offset < write_offset_ + delta.size()) {
+    DropOldest();
+  }
+
+  std::copy(delta.begin(), delta.end(), storage_.begin() + write_offset_);
+  entries_.push_back({ .offset = write_offset_, .size = delta.size() });
+  write_offset_ += delta.size();
+  bytes_ += delta.size();
+};
+
+std::optional<SaveState> RewindBuffer::StepBack() {
+  if (entries_.empty()) return std::nullopt;
+
+  const Entry entry{ entries_.back() };
+  entries_.pop_back();
+  bytes_ -= entry.size;
+  write_offset_ = entry.offset;
+
+  const uint8_t* delta{ storage_.data() + entry.offset };
+  uint8_t* newest{ reinterpret_cast<uint8_t*>(&*newest_) };
+  size_t in{ 0 };
+  while (in < entry.size) {
+    const size_t word{ static_cast<size_t>(delta[in] | (delta[in + 1] << 8)) };
+    const size_t count{ delta[in + 2] };
+    in += kRunHeaderSize;
+    for (size_t k = 0; k < count; ++k) {
+      uint64_t change;
+      uint64_t value;
+      std::memcpy(&change, delta + in, kWordSize);
+      std::memcpy(&value, newest + (word + k) * kWordSize, kWordSize);
+      value ^= change;
+      std::memcpy(newest + (word + k) * kWordSize, &value, kWordSize);
+      in += kWordSize;
+    }
+  }
+  return newest_;
+};
+
+void RewindBuffer::Clear() {
+  entries_.clear();
+  write_offset_ = 0;
+  bytes_ = 0;
+  newest_.reset();
+};
+
+void RewindBuffer::DropOldest() {
+  bytes_ -= entries_.front().size;
+  entries_.pop_front();
+};
+
+}  // namespace chip8
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "save_state.h"
+
+namespace chip8 {
+
+// History of save states kept as per-frame deltas in a fixed amount of memory. Each recorded frame stores
+// only the 64-bit words of the SaveState that changed since the previous one, so a few minutes of history at
+// 60 Hz fit in a few MB. When the buffer is full the oldest frames are dropped.
+//
+// A delta is a sequence of `<uint16 first word><uint8 count>` headers, each followed by the XOR of `count`
+// consecutive words with their previous values. XORs undo themselves, so the same delta takes the newest
+// state back to the previous one.
+//
+// A frame is either recorded whole with Record, or, by a producer that knows what it changed, as just those
+// parts between BeginFrame and EndFrame. Recording then costs in proportion to the parts rather than to the
+// whole state, which is what lets an emulator record every frame even when running flat out.
+class RewindBuffer {
+ public:
+  static inline const size_t kDefaultCapacity{ 4 << 20 };
+
+  explicit RewindBuffer(size_t capacity = kDefaultCapacity);
+
+  // Appends `state` as the newest frame.
+  void Record(const SaveState& state);
+
+  // Appends a frame that is the newest one with the parts passed to Update replaced. Needs a frame recorded
+  // before, see IsEmpty; throws std::logic_error otherwise.
+  void BeginFrame();
+  // Sets the bytes at `offset` in SaveState. Parts left out keep their values, and each part must start and
+  // end on a word boundary; throws std::invalid_argument otherwise or if the part runs past the end.
+  void Update(size_t offset, std::span<const uint8_t> bytes);
+  template <typename T>
+  void Update(size_t offset, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Update(offset, std::span<const uint8_t>{ reinterpret_cast<const uint8_t*>(&value), sizeof(T) });
+  }
+  void EndFrame();
+
+  // Drops the newest frame and returns the one before it, or nullopt if no earlier frame is left.
+  std::optional<SaveState> StepBack();
+
+  // True until the first frame is recorded and after Clear.
+  bool IsEmpty() const { return !newest_.has_value(); }
+
+  // Number of frames StepBack can go back.
+  size_t Frames() const { return entries_.size(); }
+
+  // Bytes of the capacity used by deltas.
+  size_t Bytes() const { return bytes_; }
+
+  void Clear();
+
+ private:
+  static inline const size_t kWordSize{ sizeof(uint64_t) };
+  static inline const size_t kStateWords{ sizeof(SaveState) / kWordSize };
+  static inline const size_t kRunHeaderSize{ 3 };
+  static inline const size_t kMaxRunWords{ 0xFF };
+  static_assert(sizeof(SaveState) % kWordSize == 0 && kStateWords <= 0x10000);
+
+  struct Entry {
+    size_t offset;
+    size_t size;
+  };
+
+  void Store(std::span<const uint8_t> delta);
+  void DropOldest();
+
+  std::vector<uint8_t> storage_;
+  // Oldest first; offsets increase and wrap around the end of storage_ at most once.
+  std::deque<Entry> entries_;
+  size_t write_offset_{ 0 };
+  size_t bytes_{ 0 };
+  // State of the newest frame.
+  std::optional<SaveState> newest_;
+
+  // Delta of the frame being recorded, and where its last run's header is and the word after that run.
+  std::vector<uint8_t> delta_;
+  std::optional<size_t> run_;
+  size_t run_end_{ 0 };
+};
+
+}  // namespace chip8
@@ -0,0 +1,101 @@
+#include "rom_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace chip8 {
+
+Rom::Rom(const std::string& filename) {
+  const int fd{ ::open(filename.c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd < 0) {
+    throw std::invalid_argument{ "failed to open rom file" };
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    ::close(fd);
+    throw std::invalid_argument{ "rom file is not a regular file" };
+  }
+  if (static_cast<uint64_t>(info.st_size) > kMaxSize) {
+    ::close(fd);
+    throw std::invalid_argument{ "rom file is too large to fit into chip8 memory" };
+  }
+
+  size_ = static_cast<size_t>(info.st_size);
+  std::array<uint8_t, Emulator::kChip8MemorySize> image{ Emulator::kChip8InitialMemory };
+  if (size_ > 0) {
+    void* mapping{ ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) };
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error{ "Error mapping rom file" };
+    }
+    const uint8_t* data{ static_cast<const uint8_t*>(mapping) };
+    std::copy(data, data + size_, image.begin() + Emulator::kChip8ProgramStartAddress);
+    ::munmap(mapping, size_);
+  }
+  ::close(fd);
+
+  memory_.Assign(image);
+};
+
+RomCache& RomCache::Instance() {
+  static RomCache cache;
+  return cache;
+};
+
+std::shared_ptr<const Rom> RomCache::Load(const std::string& filename) {
+  struct stat info {};
+  if (::stat(filename.c_str(), &info) != 0) {
+    throw std::invalid_argument{ "failed to open rom file" };
+  }
+  const FileId id{ info.st_dev, info.st_ino };
+
+  std::lock_guard lock{ mutex_ };
+  if (auto it{ index_.find(id) }; it != index_.end()) {
+    const Entry& entry{ *it->second };
+    if (entry.size == info.st_size && entry.modified.tv_sec == info.st_mtim.tv_sec &&
+        entry.modified.tv_nsec == info.st_mtim.tv_nsec) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return entry.rom;
+    }
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+
+  std::shared_ptr<const Rom> rom{ std::make_shared<Rom>(filename) };
+  entries_.push_front({ .id = id, .size = info.st_size, .modified = info.st_mtim, .rom = rom });
+  index_.emplace(id, entries_.begin());
+  Evict();
+  return rom;
+};
+
+void RomCache::SetCapacity(size_t capacity) {
+  std::lock_guard lock{ mutex_ };
+  capacity_ = capacity;
+  Evict();
+};
+
+size_t RomCache::Size() {
+  std::lock_guard lock{ mutex_ };
+  return entries_.size();
+};
+
+void RomCache::Evict() {
+  while (entries_.size() > capacity_) {
+    index_.erase(entries_.back().id);
+    entries_.pop_back();
+  }
+};
+
+}  // namespace chip8
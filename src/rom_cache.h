@@ -0,0 +1,98 @@
+#pragma once
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "emulator.h"
+#include "paged_memory.h"
+
+namespace chip8 {
+
+// A ROM file as the memory image of an instance that just loaded it. The size is validated against the
+// program area before the file is read, and the file is only mapped for as long as it takes to build the
+// image, so a Rom holds nothing but the pages of its image.
+class Rom {
+ public:
+  // Largest program that fits between the program start address and the end of memory.
+  static inline const size_t kMaxSize{ Emulator::kChip8MemorySize - Emulator::kChip8ProgramStartAddress };
+
+  explicit Rom(const std::string& filename);
+
+  Rom(const Rom&) = delete;
+  Rom& operator=(const Rom&) = delete;
+
+  // Size of the program in bytes.
+  size_t Size() const { return size_; }
+
+  // Emulator::kChip8InitialMemory with the program at the program start address. Instances copy it,
+  // sharing its pages until they write to them.
+  const PagedMemory& Memory() const { return memory_; }
+
+ private:
+  size_t size_{ 0 };
+  PagedMemory memory_;
+};
+
+// Process-wide cache of loaded ROMs keyed by file identity, i.e. device and inode, so one file reached
+// through several paths or links is loaded once. A file modified since it was cached is loaded again. The
+// least recently loaded ROMs are evicted beyond the capacity, so a long run over many ROMs keeps a bounded
+// number of images; instances already running from an evicted ROM keep the pages they share with it. Safe
+// to use from several threads.
+class RomCache {
+ public:
+  static inline const size_t kDefaultCapacity{ 256 };
+
+  static RomCache& Instance();
+
+  // Returns the cached ROM for `filename`, loading it on first use. Throws like Rom's constructor; failed
+  // loads are not cached.
+  std::shared_ptr<const Rom> Load(const std::string& filename);
+
+  // Evicts the least recently loaded ROMs down to `capacity`.
+  void SetCapacity(size_t capacity);
+  size_t Size();
+
+ private:
+  struct FileId {
+    dev_t device;
+    ino_t inode;
+
+    bool operator==(const FileId&) const = default;
+  };
+
+  struct FileIdHash {
+    size_t operator()(const FileId& id) const {
+      return std::hash<uint64_t>{}(static_cast<uint64_t>(id.device) * 0x9e3779b97f4a7c15 ^ id.inode);
+    }
+  };
+
+  struct Entry {
+    FileId id;
+    // Size and modification time when loaded, to notice the file changing under the same inode.
+    off_t size;
+    timespec modified;
+    std::shared_ptr<const Rom> rom;
+  };
+
+  RomCache() = default;
+
+  void Evict();
+
+  std::mutex mutex_;
+  size_t capacity_{ kDefaultCapacity };
+  // Most recently loaded first.
+  std::list<Entry> entries_;
+  std::unordered_map<FileId, std::list<Entry>::iterator, FileIdHash> index_;
+};
+
+}  // namespace chip8
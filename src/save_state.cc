@@ -0,0 +1,111 @@
+#include "save_state.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace chip8 {
+
+namespace {
+
+using StateBytes = std::array<uint8_t, sizeof(SaveState)>;
+
+// Unchanged bytes shorter than this stay inside a literal, since a new record costs four bytes.
+constexpr size_t kMinUnchangedRun{ 4 };
+constexpr size_t kMaxRecordField{ 0xFFFF };
+
+StateBytes ToBytes(const SaveState& state) {
+  StateBytes bytes;
+  std::memcpy(bytes.data(), &state, sizeof(SaveState));
+  return bytes;
+}
+
+// The object representation of `state`, which has no padding.
+std::span<const uint8_t, sizeof(SaveState)> BytesOf(const SaveState& state) {
+  return std::span<const uint8_t, sizeof(SaveState)>{ reinterpret_cast<const uint8_t*>(&state),
+                                                       sizeof(SaveState) };
+}
+
+void AppendUint16(std::vector<uint8_t>& out, size_t value) {
+  out.push_back(static_cast<uint8_t>(value & 0xFF));
+  out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+}  // namespace
+
+std::vector<uint8_t> CompressSaveState(const SaveState& state, const SaveState& base) {
+  const auto current{ BytesOf(state) };
+  const auto reference{ BytesOf(base) };
+  auto unchanged = [&](size_t i) { return current[i] == reference[i]; };
+
+  std::vector<uint8_t> encoded;
+  size_t i{ 0 };
+  while (i < current.size()) {
+    const size_t run_start{ i };
+    // Most of a state is unchanged from frame to frame, so skip whole words first.
+    while (i + sizeof(uint64_t) <= current.size() && i + sizeof(uint64_t) - run_start <= kMaxRecordField &&
+           std::memcmp(&current[i], &reference[i], sizeof(uint64_t)) == 0) {
+      i += sizeof(uint64_t);
+    }
+    while (i < current.size() && i - run_start < kMaxRecordField && unchanged(i)) ++i;
+    const size_t run{ i - run_start };
+
+    // Extend the literal until a long enough unchanged run or the end of the state.
+    const size_t literal_start{ i };
+    while (i < current.size() && i - literal_start < kMaxRecordField) {
+      if (unchanged(i)) {
+        const size_t gap_end{ std::min(i + kMinUnchangedRun, current.size()) };
+        size_t j{ i };
+        while (j < gap_end && unchanged(j)) ++j;
+        if (j == gap_end) break;
+        i = std::min(j, literal_start + kMaxRecordField);
+        continue;
+      }
+      ++i;
+    }
+
+    AppendUint16(encoded, run);
+    AppendUint16(encoded, i - literal_start);
+    for (size_t k = literal_start; k < i; ++k) {
+      encoded.push_back(current[k] ^ reference[k]);
+    }
+  }
+  return encoded;
+};
+
+SaveState DecompressSaveState(std::span<const uint8_t> encoded, const SaveState& base) {
+  StateBytes bytes{ ToBytes(base) };
+
+  size_t in{ 0 };
+  size_t out{ 0 };
+  while (in < encoded.size()) {
+    if (encoded.size() - in < 4) {
+      throw std::invalid_argument{ "truncated save state record" };
+    }
+    const size_t run{ static_cast<size_t>(encoded[in] | (encoded[in + 1] << 8)) };
+    const size_t literal{ static_cast<size_t>(encoded[in + 2] | (encoded[in + 3] << 8)) };
+    in += 4;
+    if (run + literal > bytes.size() - out || literal > encoded.size() - in) {
+      throw std::invalid_argument{ "save state record out of bounds" };
+    }
+
+    out += run;
+    for (size_t k = 0; k < literal; ++k) {
+      bytes[out++] ^= encoded[in++];
+    }
+  }
+  if (out != bytes.size()) {
+    throw std::invalid_argument{ "save state encoding does not cover the whole state" };
+  }
+
+  SaveState state;
+  std::memcpy(&state, bytes.data(), sizeof(SaveState));
+  return state;
+};
+
+}  // namespace chip8
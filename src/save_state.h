@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace chip8 {
+
+// Complete emulator state in a fixed binary layout with no implicit padding, so a SaveState can be written
+// to disk or copied between processes with memcpy. Multi-byte fields are stored in host byte order.
+//
+// The layout is identified by kVersion; any change to the fields must bump it.
+struct SaveState {
+  static inline const uint32_t kMagic{ 0x53533843 };  // "C8SS" read as little endian
+  static inline const uint16_t kVersion{ 4 };
+
+  // Set in `key_wait` while FX0A waits for a key; the low nibble is the destination register.
+  static inline const uint8_t kKeyWaitFlag{ 0x80 };
+
+  uint32_t magic{ kMagic };
+  uint16_t version{ kVersion };
+  // 1 at high resolution, see Framebuffer::hires.
+  uint8_t hires{ 0 };
+  uint8_t reserved0{ 0 };
+  uint64_t cycles{ 0 };
+  uint64_t timer_ticks{ 0 };
+  std::array<uint32_t, 4> random_state{};
+  std::array<uint64_t, 64> framebuffer_left{};
+  std::array<uint64_t, 64> framebuffer_right{};
+  std::array<uint16_t, 16> stack{};
+  uint16_t program_counter{ 0 };
+  uint16_t index_register{ 0 };
+  std::array<uint8_t, 16> variable_registers{};
+  uint8_t stack_pointer{ 0 };
+  uint8_t delay_timer{ 0 };
+  uint8_t sound_timer{ 0 };
+  uint8_t key_wait{ 0 };
+  std::array<uint8_t, 4096> memory{};
+
+  bool operator==(const SaveState&) const = default;
+};
+
+static_assert(std::is_trivially_copyable_v<SaveState> && std::is_standard_layout_v<SaveState>);
+static_assert(sizeof(SaveState) == 5216, "SaveState layout changed; bump SaveState::kVersion");
+
+// Encodes `state` as its byte-wise XOR against `base` with runs of unchanged bytes collapsed. Against the
+// state of the same ROM right after loading, a snapshot shrinks to roughly the bytes the program changed.
+//
+// The encoding is a sequence of `<uint16 unchanged run><uint16 literal count><literal bytes>` records that
+// together cover the whole SaveState.
+std::vector<uint8_t> CompressSaveState(const SaveState& state, const SaveState& base);
+
+// Inverse of CompressSaveState. Throws std::invalid_argument on a malformed encoding.
+SaveState DecompressSaveState(std::span<const uint8_t> encoded, const SaveState& base);
+
+}  // namespace chip8
@@ -0,0 +1,30 @@
+#include "scheduler.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace chip8 {
+
+FrameScheduler::FrameScheduler(uint32_t frames_per_second) {
+  if (frames_per_second == 0) {
+    throw std::invalid_argument{ "frame rate must be positive" };
+  }
+  frame_period_ = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds{ 1 }) / frames_per_second;
+  deadline_ = Clock::now() + frame_period_;
+};
+
+FrameScheduler::Clock::duration FrameScheduler::WaitForNextFrame() {
+  const auto deadline{ deadline_ };
+  const bool late{ Clock::now() >= deadline };
+  std::this_thread::sleep_until(deadline);
+  deadline_ += frame_period_;
+
+  const auto now{ Clock::now() };
+  if (now > deadline_ + kMaxFramesBehind * frame_period_) {
+    deadline_ = now + frame_period_;
+  }
+  return late ? Clock::duration::zero() : now - deadline;
+};
+
+}  // namespace chip8
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace chip8 {
+
+// Paces a loop to a fixed frame rate. Sleeps once per frame until an absolute deadline, so oversleeping in
+// one frame is absorbed by the next instead of accumulating as drift.
+class FrameScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit FrameScheduler(uint32_t frames_per_second);
+
+  // Blocks until the end of the current frame. Returns how far past the deadline the thread woke up, or zero
+  // if the frame was already late and there was nothing to sleep.
+  Clock::duration WaitForNextFrame();
+
+ private:
+  // When the loop falls this many frames behind it resynchronizes to the current time instead of running a
+  // burst of unpaced frames to catch up.
+  static inline const int kMaxFramesBehind{ 2 };
+
+  Clock::duration frame_period_;
+  Clock::time_point deadline_;
+};
+
+}  // namespace chip8
@@ -1,84 +1,25 @@
 #pragma once
 
-#include <SFML/Graphics.hpp>
-#include <array>
-#include <atomic>
-#include <iostream>
-#include <mutex>
-#include <optional>
-#include <thread>
+#include <string>
 
-namespace chip8 {
-
-class Screen : private sf::RenderWindow {
- private:
-  using Base = sf::RenderWindow;
+#include "framebuffer.h"
 
-  static inline const size_t kPixelSize{ 20 };
-  static inline const size_t kScreenWidth{ kPixelSize * 64 };
-  static inline const size_t kScreenHeight{ kPixelSize * 32 };
+namespace chip8 {
 
+// Display frontend driven by the emulator core. Implementations own whatever window or buffer the frame
+// ends up in; the core never depends on a particular graphics library.
+class Screen {
  public:
-  Screen() : Base{ sf::VideoMode{ { kScreenWidth, kScreenHeight } }, "Chip8" } {
-    clear(sf::Color::Black);
-    display();
-  };
-
-  bool IsOpen() {
-    if (closed_) return false;
-
-    sf::Event event;
-    bool ok{ Base::pollEvent(event) };
-    if (ok && event.type == sf::Event::Closed) {
-      close();
-      closed_ = true;
-      return false;
-    }
-
-    return true;
-  }
-
-  std::optional<sf::Keyboard::Key> WaitKeyPress() {
-    if (closed_) return std::nullopt;
-
-    sf::Event event;
-    if (waitEvent(event)) {
-      if (event.type == sf::Event::Closed) {
-        close();
-        closed_ = true;
-        return std::nullopt;
-      }
-      if (event.type == sf::Event::KeyPressed) return event.key.code;
-    }
-
-    return sf::Keyboard::Unknown;
-  };
-
-  void Draw(const std::array<std::array<uint8_t, 64>, 32>& screen) {
-    if (closed_) return;
-
-    clear(sf::Color::Black);
-
-    float position_y{ 0 };
-    float position_x{ 0 };
+  virtual ~Screen() = default;
 
-    for (size_t y = 0; y < 32; ++y) {
-      for (size_t x = 0; x < 64; ++x) {
-        sf::RectangleShape pixel{ sf::Vector2f(kPixelSize, kPixelSize) };
-        pixel.setFillColor(screen[y][x] ? sf::Color::White : sf::Color::Black);
-        pixel.setPosition(sf::Vector2f(position_x, position_y));
-        draw(pixel);
-        position_x += kPixelSize;
-      }
-      position_x = 0;
-      position_y += kPixelSize;
-    }
+  // Returns false once the frontend has been closed and the execution loop should stop.
+  virtual bool IsOpen() = 0;
 
-    display();
-  };
+  virtual void Draw(const Framebuffer& screen) = 0;
 
- private:
-  bool closed_{ false };
+  // Shows a line of status text next to the picture, e.g. in the window title. Frontends without anywhere
+  // to put it ignore it.
+  virtual void ShowStatus(const std::string& /*status*/) {}
 };
 
 }  // namespace chip8
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <SFML/Window.hpp>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "../keyboard.h"
+#include "screen.h"
+
+namespace chip8 {
+
+// Keypad driven by the window's key events. The state is a 16-bit mask updated while SfmlScreen drains its
+// event queue once per frame, so testing a key is a single bit test instead of a call into the OS. The mask
+// is atomic, so the emulator may latch it from a thread other than the one pumping the window.
+class SfmlKeyboard : public Keyboard {
+ public:
+  // Host key for each chip8 key, indexed by chip8 key.
+  using KeyMap = std::array<sf::Keyboard::Key, 16>;
+
+  // The usual layout of the COSMAC VIP hex keypad on the left side of a QWERTY keyboard:
+  //   1 2 3 C     1 2 3 4
+  //   4 5 6 D     Q W E R
+  //   7 8 9 E     A S D F
+  //   A 0 B F     Z X C V
+  static inline const KeyMap kDefaultKeyMap{
+    sf::Keyboard::X, sf::Keyboard::Num1, sf::Keyboard::Num2, sf::Keyboard::Num3,
+    sf::Keyboard::Q, sf::Keyboard::W,    sf::Keyboard::E,    sf::Keyboard::A,
+    sf::Keyboard::S, sf::Keyboard::D,    sf::Keyboard::Z,    sf::Keyboard::C,
+    sf::Keyboard::Num4, sf::Keyboard::R, sf::Keyboard::F,    sf::Keyboard::V,
+  };
+
+  explicit SfmlKeyboard(SfmlScreen& screen, const KeyMap& key_map = kDefaultKeyMap) : screen_{ screen } {
+    chip8_keys_.fill(kUnmapped);
+    for (uint8_t key = 0; key < key_map.size(); ++key) {
+      if (key_map[key] >= 0 && key_map[key] < sf::Keyboard::KeyCount) {
+        chip8_keys_[key_map[key]] = key;
+      }
+    }
+    screen_.SetEventHandler([this](const sf::Event& event) { OnEvent(event); });
+  };
+
+  ~SfmlKeyboard() override { screen_.SetEventHandler(nullptr); }
+
+  SfmlKeyboard(const SfmlKeyboard&) = delete;
+  SfmlKeyboard& operator=(const SfmlKeyboard&) = delete;
+
+  // Parses a key map written as the host key for chip8 keys 0 to F in order, one letter or digit each, e.g.
+  // "x123qweasdzc4rfv" for kDefaultKeyMap.
+  static KeyMap ParseKeyMap(const std::string& spec) {
+    if (spec.size() != 16) {
+      throw std::invalid_argument{ "key map must name 16 keys" };
+    }
+
+    KeyMap key_map{};
+    for (size_t key = 0; key < spec.size(); ++key) {
+      const char c{ static_cast<char>(std::tolower(static_cast<unsigned char>(spec[key]))) };
+      if (c >= 'a' && c <= 'z') {
+        key_map[key] = static_cast<sf::Keyboard::Key>(sf::Keyboard::A + (c - 'a'));
+      } else if (c >= '0' && c <= '9') {
+        key_map[key] = static_cast<sf::Keyboard::Key>(sf::Keyboard::Num0 + (c - '0'));
+      } else {
+        throw std::invalid_argument{ "key map may only use letters and digits" };
+      }
+    }
+    return key_map;
+  }
+
+  bool IsKeyPressed(uint8_t key) override {
+    return (keys_.load(std::memory_order_relaxed) >> (key & 0xF)) & 1;
+  };
+
+  uint16_t LatchKeys(uint64_t /*frame*/) override { return keys_.load(std::memory_order_relaxed); }
+
+ private:
+  static inline const uint8_t kUnmapped{ 0xFF };
+
+  std::optional<uint8_t> ToChip8(sf::Keyboard::Key key) const {
+    if (key < 0 || key >= sf::Keyboard::KeyCount || chip8_keys_[key] == kUnmapped) return std::nullopt;
+    return chip8_keys_[key];
+  }
+
+  void OnEvent(const sf::Event& event) {
+    switch (event.type) {
+      case sf::Event::KeyPressed:
+        if (auto key{ ToChip8(event.key.code) }) keys_.fetch_or(static_cast<uint16_t>(1 << *key));
+        break;
+      case sf::Event::KeyReleased:
+        if (auto key{ ToChip8(event.key.code) }) keys_.fetch_and(static_cast<uint16_t>(~(1 << *key)));
+        break;
+      case sf::Event::LostFocus:
+        // Releases that happen while another window has focus never arrive.
+        keys_ = 0;
+        break;
+      default:
+        break;
+    }
+  }
+
+  SfmlScreen& screen_;
+  // Chip8 key for each host key, kUnmapped if none.
+  std::array<uint8_t, sf::Keyboard::KeyCount> chip8_keys_{};
+  // Written by the thread pumping the window, read by the emulation thread.
+  std::atomic<uint16_t> keys_{ 0 };
+};
+
+}  // namespace chip8
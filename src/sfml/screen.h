@@ -0,0 +1,106 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "../screen.h"
+
+namespace chip8 {
+
+// The window is only opened the first time the screen is used, so constructing one is nearly free and hosts
+// that end up never showing anything never touch the window system.
+class SfmlScreen : public Screen {
+ private:
+  static inline const size_t kPixelSize{ 10 };
+  static inline const size_t kFrameWidth{ kFramebufferWidth };
+  static inline const size_t kFrameHeight{ kFramebufferHeight };
+  static inline const size_t kScreenWidth{ kPixelSize * kFrameWidth };
+  static inline const size_t kScreenHeight{ kPixelSize * kFrameHeight };
+
+ public:
+  SfmlScreen() = default;
+
+  // Receives every event drained from the window's queue, e.g. to track the keypad.
+  void SetEventHandler(std::function<void(const sf::Event&)> handler) { event_handler_ = std::move(handler); }
+
+  // Called once per frame, so the whole pending event queue is drained.
+  bool IsOpen() override {
+    if (closed_) return false;
+
+    sf::RenderWindow& window{ Window() };
+    sf::Event event;
+    while (window.pollEvent(event)) {
+      if (event.type == sf::Event::Closed) {
+        window.close();
+        closed_ = true;
+        return false;
+      }
+      if (event_handler_) event_handler_(event);
+    }
+
+    return true;
+  }
+
+  // The frame is uploaded as one 128x64 texture and scaled up by the GPU, so presenting costs a single draw
+  // call regardless of kPixelSize. Low resolution frames fill the texture with 2x2 texels per pixel.
+  void Draw(const Framebuffer& screen) override {
+    if (closed_) return;
+
+    sf::RenderWindow& window{ Window() };
+    const size_t scale{ kFrameWidth / screen.Width() };
+    for (size_t y = 0; y < kFrameHeight; ++y) {
+      for (size_t x = 0; x < kFrameWidth; ++x) {
+        const bool set{ IsPixelSet(screen, x / scale, y / scale) };
+        const sf::Color color{ set ? sf::Color::White : sf::Color::Black };
+        sf::Uint8* pixel{ &pixels_[(y * kFrameWidth + x) * 4] };
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+        pixel[3] = color.a;
+      }
+    }
+    texture_.update(pixels_.data());
+
+    window.clear(sf::Color::Black);
+    window.draw(sprite_);
+    window.display();
+  };
+
+  void ShowStatus(const std::string& status) override { Window().setTitle("Chip8 | " + status); }
+
+ private:
+  // Opens the window on first use.
+  sf::RenderWindow& Window() {
+    if (window_.has_value()) return *window_;
+
+    window_.emplace(sf::VideoMode{ { kScreenWidth, kScreenHeight } }, "Chip8");
+    if (!texture_.create(kFrameWidth, kFrameHeight)) {
+      throw std::runtime_error{ "failed to create screen texture" };
+    }
+    sprite_.setTexture(texture_, true);
+    sprite_.setScale(kPixelSize, kPixelSize);
+
+    window_->clear(sf::Color::Black);
+    window_->display();
+    return *window_;
+  }
+
+  // Declared first so it outlives the texture created for it.
+  std::optional<sf::RenderWindow> window_;
+  std::array<sf::Uint8, kFrameWidth * kFrameHeight * 4> pixels_{};
+  sf::Texture texture_;
+  sf::Sprite sprite_;
+  bool closed_{ false };
+  std::function<void(const sf::Event&)> event_handler_;
+};
+
+}  // namespace chip8
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "../speaker.h"
+#include "../tone.h"
+
+namespace chip8 {
+
+// Streams a synthesized tone through SFML. The stream pulls samples from SFML's own audio thread, while
+// Beep only hands the timer load over to the generator, so the emulation thread never waits on the device.
+// The audio device is only opened by the first beep; programs that never sound never touch it.
+class SfmlSpeaker : public Speaker, private sf::SoundStream {
+ public:
+  SfmlSpeaker() = default;
+
+  ~SfmlSpeaker() override {
+    if (started_) stop();
+  }
+
+  SfmlSpeaker(const SfmlSpeaker&) = delete;
+  SfmlSpeaker& operator=(const SfmlSpeaker&) = delete;
+
+  void Beep(uint8_t ticks) override {
+    tone_.Beep(ticks);
+    if (ticks > 0 && !started_) {
+      initialize(1, tone_.SampleRate());
+      play();
+      started_ = true;
+    }
+  }
+
+ private:
+  // About 12 ms at the default sample rate, which bounds how late a beep starts.
+  static inline const size_t kChunkSamples{ 512 };
+
+  bool onGetData(Chunk& data) override {
+    tone_.Generate(samples_);
+    data.samples = samples_.data();
+    data.sampleCount = samples_.size();
+    return true;
+  }
+
+  void onSeek(sf::Time /*offset*/) override {}
+
+  ToneGenerator tone_;
+  std::array<int16_t, kChunkSamples> samples_{};
+  bool started_{ false };
+};
+
+}  // namespace chip8
@@ -1,25 +1,18 @@
 #pragma once
 
-#include <SFML/Audio.hpp>
-#include <exception>
-#include <string>
+#include <cstdint>
 
 namespace chip8 {
 
+// Audio frontend driven by the emulator core.
 class Speaker {
  public:
-  explicit Speaker(const std::string& filename) {
-    if (!buffer_.loadFromFile(filename))
-      throw std::invalid_argument{ "failed to load sound buffer from file" };
+  virtual ~Speaker() = default;
 
-    sound_.setBuffer(buffer_);
-  };
-
-  void Play() { sound_.play(); }
-
- private:
-  sf::SoundBuffer buffer_;
-  sf::Sound sound_;
+  // Called on every load of the sound timer, i.e. only on its edges rather than once per tick: the tone
+  // sounds for `ticks` periods of the 60 Hz timer clock from now, replacing any tone still sounding. 0
+  // silences the speaker.
+  virtual void Beep(uint8_t ticks) = 0;
 };
 
 }  // namespace chip8
@@ -0,0 +1,129 @@
+#include "telemetry.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chip8 {
+
+namespace {
+
+double Milliseconds(Telemetry::Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>{ duration }.count();
+}
+
+// Nearest-rank percentile; reorders `samples`.
+double Percentile(std::vector<double>& samples, double percentile) {
+  if (samples.empty()) return 0.0;
+
+  const size_t rank{ std::min(samples.size() - 1, static_cast<size_t>(percentile / 100 * samples.size())) };
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples[rank];
+}
+
+}  // namespace
+
+std::string Telemetry::Report::Summary() const {
+  return fmt::format(
+      "{:.0f} ips | frame p50 {:.1f} p99 {:.1f} ms | draw p99 {:.2f} ms | overshoot p99 {:.2f} ms | "
+      "input p50 {:.1f} ms",
+      instructions_per_second, frame_ms_p50, frame_ms_p99, draw_ms_p99, overshoot_ms_p99, latency_ms_p50);
+};
+
+void Telemetry::Report::Log() const {
+  spdlog::info(
+      "telemetry ips={:.0f} frames={} frame_ms_p50={:.3f} frame_ms_p99={:.3f} draws={} draw_ms_p50={:.3f} "
+      "draw_ms_p99={:.3f} overshoot_ms_p50={:.3f} overshoot_ms_p99={:.3f} inputs={} latency_ms_p50={:.3f} "
+      "latency_ms_p99={:.3f}",
+      instructions_per_second, frames, frame_ms_p50, frame_ms_p99, draws, draw_ms_p50, draw_ms_p99,
+      overshoot_ms_p50, overshoot_ms_p99, inputs, latency_ms_p50, latency_ms_p99);
+};
+
+Telemetry::Telemetry(Clock::duration report_period)
+    : report_period_{ report_period }, report_start_{ Clock::now() } {};
+
+void Telemetry::RecordFrame(uint64_t cycles) {
+  const auto now{ Clock::now() };
+  std::lock_guard lock{ mutex_ };
+  if (last_frame_.has_value()) {
+    frame_ms_.push_back(Milliseconds(now - *last_frame_));
+  }
+  last_frame_ = now;
+  if (!report_cycles_.has_value()) report_cycles_ = cycles;
+  cycles_ = cycles;
+};
+
+void Telemetry::RecordOvershoot(Clock::duration overshoot) {
+  std::lock_guard lock{ mutex_ };
+  overshoot_ms_.push_back(Milliseconds(overshoot));
+};
+
+void Telemetry::RecordInput() {
+  const auto now{ Clock::now() };
+  std::lock_guard lock{ mutex_ };
+  if (!latched_input_.has_value()) latched_input_ = now;
+};
+
+void Telemetry::RecordPublish() {
+  std::lock_guard lock{ mutex_ };
+  if (latched_input_.has_value() && !published_input_.has_value()) {
+    published_input_ = latched_input_;
+  }
+  latched_input_.reset();
+};
+
+std::optional<Telemetry::Clock::time_point> Telemetry::TakePublishedInput() {
+  std::lock_guard lock{ mutex_ };
+  return std::exchange(published_input_, std::nullopt);
+};
+
+void Telemetry::RecordDraw(Clock::duration elapsed) {
+  std::lock_guard lock{ mutex_ };
+  draw_ms_.push_back(Milliseconds(elapsed));
+};
+
+void Telemetry::RecordLatency(Clock::duration latency) {
+  std::lock_guard lock{ mutex_ };
+  latency_ms_.push_back(Milliseconds(latency));
+};
+
+std::optional<Telemetry::Report> Telemetry::TakeReport() {
+  const auto now{ Clock::now() };
+  std::lock_guard lock{ mutex_ };
+  if (now - report_start_ < report_period_) return std::nullopt;
+
+  const double seconds{ std::chrono::duration<double>{ now - report_start_ }.count() };
+  const Report report{
+    .instructions_per_second = static_cast<double>(cycles_ - report_cycles_.value_or(cycles_)) / seconds,
+    .frames = frame_ms_.size(),
+    .frame_ms_p50 = Percentile(frame_ms_, 50),
+    .frame_ms_p99 = Percentile(frame_ms_, 99),
+    .draws = draw_ms_.size(),
+    .draw_ms_p50 = Percentile(draw_ms_, 50),
+    .draw_ms_p99 = Percentile(draw_ms_, 99),
+    .overshoot_ms_p50 = Percentile(overshoot_ms_, 50),
+    .overshoot_ms_p99 = Percentile(overshoot_ms_, 99),
+    .inputs = latency_ms_.size(),
+    .latency_ms_p50 = Percentile(latency_ms_, 50),
+    .latency_ms_p99 = Percentile(latency_ms_, 99),
+  };
+
+  report_start_ = now;
+  report_cycles_ = cycles_;
+  frame_ms_.clear();
+  draw_ms_.clear();
+  overshoot_ms_.clear();
+  latency_ms_.clear();
+  return report;
+};
+
+}  // namespace chip8
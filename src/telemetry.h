@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace chip8 {
+
+// Live frame timing and latency metrics of a running frontend, summarized once per report period. The
+// emulation thread records frames, scheduler overshoot and keypad changes, the render thread records draws
+// and presents. Each thread only records a handful of samples per frame, so the samples sit behind a plain
+// mutex; the instruction loop never touches it.
+class Telemetry {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static inline const Clock::duration kDefaultReportPeriod{ std::chrono::seconds{ 1 } };
+
+  // Times are in milliseconds; percentiles of an empty sample set are 0.
+  struct Report {
+    double instructions_per_second;
+    size_t frames;
+    double frame_ms_p50;
+    double frame_ms_p99;
+    size_t draws;
+    double draw_ms_p50;
+    double draw_ms_p99;
+    double overshoot_ms_p50;
+    double overshoot_ms_p99;
+    // From the frame the emulator latched a keypad change to the first present after it.
+    size_t inputs;
+    double latency_ms_p50;
+    double latency_ms_p99;
+
+    // One line for a window title or status bar.
+    std::string Summary() const;
+    // Logs the report through spdlog as `key=value` pairs.
+    void Log() const;
+  };
+
+  explicit Telemetry(Clock::duration report_period = kDefaultReportPeriod);
+
+  // Emulation thread. Called after every frame with the emulator's cycle count; the frame time is the time
+  // since the previous call.
+  void RecordFrame(uint64_t cycles);
+  void RecordOvershoot(Clock::duration overshoot);
+  // The emulator latched a keypad state different from the previous one.
+  void RecordInput();
+  // The emulator drew a frame to its screen. Starts the latency clock of any keypad change latched since
+  // the last publish.
+  void RecordPublish();
+
+  // Render thread. Takes the time of the earliest keypad change published since the last call; a present
+  // that follows shows the response to it.
+  std::optional<Clock::time_point> TakePublishedInput();
+  void RecordDraw(Clock::duration elapsed);
+  void RecordLatency(Clock::duration latency);
+
+  // Any thread. Summarizes and clears the samples once a report period has elapsed since the last report.
+  std::optional<Report> TakeReport();
+
+ private:
+  Clock::duration report_period_;
+  std::mutex mutex_;
+  Clock::time_point report_start_;
+  std::optional<uint64_t> report_cycles_;
+  uint64_t cycles_{ 0 };
+  std::optional<Clock::time_point> last_frame_;
+  std::optional<Clock::time_point> latched_input_;
+  std::optional<Clock::time_point> published_input_;
+  std::vector<double> frame_ms_;
+  std::vector<double> draw_ms_;
+  std::vector<double> overshoot_ms_;
+  std::vector<double> latency_ms_;
+};
+
+}  // namespace chip8
@@ -0,0 +1,80 @@
+#include "threaded_frontend.h"
+
+#include <exception>
+#include <thread>
+
+#include "emulator.h"
+#include "framebuffer.h"
+#include "quirks.h"
+#include "scheduler.h"
+#include "screen.h"
+#include "telemetry.h"
+
+namespace chip8 {
+
+void FrameHandoff::Draw(const Framebuffer& screen) {
+  frames_.Back() = screen;
+  frames_.Publish();
+};
+
+bool FrameHandoff::PresentTo(Screen& window) {
+  if (!frames_.Acquire()) return false;
+
+  window.Draw(frames_.Front());
+  return true;
+};
+
+template <Quirks kQuirks>
+void RunEmulationThread(BasicEmulator<kQuirks>& emulator, FrameHandoff& frames, Screen& window,
+                        Telemetry* telemetry) {
+  emulator.AttachTelemetry(telemetry);
+
+  std::exception_ptr error;
+  std::thread emulation{ [&] {
+    try {
+      emulator.StartExecutionLoop();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    frames.Close();
+  } };
+
+  // The window only needs to keep up with the display, not with the emulator: in turbo mode thousands of
+  // frames a second are published and all but the newest are skipped.
+  FrameScheduler scheduler{ Emulator::kChip8TimerFrequency };
+  while (frames.IsOpen() && window.IsOpen()) {
+    if (telemetry == nullptr) {
+      frames.PresentTo(window);
+    } else {
+      // Taken before presenting, so whatever frame is presented next was published after the input.
+      const auto input{ telemetry->TakePublishedInput() };
+      const auto start{ Telemetry::Clock::now() };
+      if (frames.PresentTo(window)) {
+        telemetry->RecordDraw(Telemetry::Clock::now() - start);
+      }
+      if (input.has_value()) {
+        telemetry->RecordLatency(Telemetry::Clock::now() - *input);
+      }
+      if (const auto report{ telemetry->TakeReport() }) {
+        window.ShowStatus(report->Summary());
+        report->Log();
+      }
+    }
+    scheduler.WaitForNextFrame();
+  }
+  frames.Close();
+  emulation.join();
+  emulator.AttachTelemetry(nullptr);
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+};
+
+#define CHIP8_INSTANTIATE_RUN_EMULATION_THREAD(profile, name)                                              \
+  template void RunEmulationThread(BasicEmulator<profile>& emulator, FrameHandoff& frames, Screen& window, \
+                                   Telemetry* telemetry);
+CHIP8_QUIRK_PROFILES(CHIP8_INSTANTIATE_RUN_EMULATION_THREAD)
+#undef CHIP8_INSTANTIATE_RUN_EMULATION_THREAD
+
+}  // namespace chip8
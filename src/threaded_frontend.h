@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+
+#include "emulator.h"
+#include "framebuffer.h"
+#include "quirks.h"
+#include "screen.h"
+#include "telemetry.h"
+#include "triple_buffer.h"
+
+namespace chip8 {
+
+// Splits a frontend across threads so the emulation thread never waits on the window, and a slow vsync or
+// compositor never stalls emulation. Sound needs no thread of its own here: speakers such as SfmlSpeaker
+// only hand sound timer loads to an audio thread the device already runs.
+
+// Screen the emulation thread draws into while the render thread owns the real window. Frames cross over
+// through a triple buffer: publishing never blocks, and frames the render thread had no time for are
+// dropped in favour of the newest one.
+class FrameHandoff : public Screen {
+ public:
+  // Emulation thread.
+  bool IsOpen() override { return open_.load(std::memory_order_acquire); }
+  void Draw(const Framebuffer& screen) override;
+
+  // Either thread. Stops both the execution loop and RunEmulationThread's render loop.
+  void Close() { open_.store(false, std::memory_order_release); }
+
+  // Render thread. Draws the newest published frame to `window` if one arrived since the last call.
+  bool PresentTo(Screen& window);
+
+ private:
+  TripleBuffer<Framebuffer> frames_;
+  std::atomic<bool> open_{ true };
+};
+
+// Runs the execution loop of `emulator`, which must draw to `frames`, on a thread of its own. Meanwhile the
+// calling thread pumps `window` and presents the newest frame to it at 60 Hz, until either the window is
+// closed or the execution loop ends. Rethrows whatever the execution loop threw.
+//
+// With `telemetry`, which is attached to the emulator for the run, draws and input latency are recorded as
+// well, and every report is shown as the window's status and logged.
+// Instantiated for every profile in CHIP8_QUIRK_PROFILES.
+template <Quirks kQuirks>
+void RunEmulationThread(BasicEmulator<kQuirks>& emulator, FrameHandoff& frames, Screen& window,
+                        Telemetry* telemetry = nullptr);
+
+}  // namespace chip8
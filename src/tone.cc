@@ -0,0 +1,39 @@
+#include "tone.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+
+namespace chip8 {
+
+ToneGenerator::ToneGenerator(uint32_t sample_rate, uint32_t frequency, int16_t amplitude)
+    : sample_rate_{ sample_rate }, frequency_{ frequency }, amplitude_{ amplitude } {
+  if (frequency == 0 || frequency * 2 > sample_rate) {
+    throw std::invalid_argument{ "tone frequency must be positive and below half the sample rate" };
+  }
+};
+
+void ToneGenerator::Generate(std::span<int16_t> samples) {
+  const uint32_t pending{ pending_.exchange(0, std::memory_order_acquire) };
+  if (pending & kPending) {
+    // A tone that starts from silence starts on a rising edge; one that extends a running tone keeps its
+    // phase, so reloading the timer never clicks.
+    if (remaining_ == 0) phase_ = 0;
+    remaining_ = static_cast<uint64_t>(pending & 0xFF) * sample_rate_ / 60;
+  }
+
+  const size_t tone{ static_cast<size_t>(std::min<uint64_t>(remaining_, samples.size())) };
+  for (size_t i = 0; i < tone; ++i) {
+    // The frequency is a whole number of hertz, so the wave repeats exactly once per second of samples.
+    const uint64_t half_periods{ static_cast<uint64_t>(phase_) * frequency_ * 2 / sample_rate_ };
+    samples[i] = (half_periods & 1) ? static_cast<int16_t>(-amplitude_) : amplitude_;
+    phase_ = phase_ + 1 == sample_rate_ ? 0 : phase_ + 1;
+  }
+  remaining_ -= tone;
+  std::fill(samples.begin() + tone, samples.end(), 0);
+};
+
+}  // namespace chip8
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+namespace chip8 {
+
+// Square wave beeper synthesized sample by sample. The emulator side only reports sound timer loads, and
+// the audio side turns each one into exactly ticks * sample_rate / 60 samples of tone, so a beep lasts as
+// long as the timer no matter when the audio thread gets to it. Nothing has to be loaded from disk, and
+// silence costs one fill per buffer.
+class ToneGenerator {
+ public:
+  static inline const uint32_t kDefaultSampleRate{ 44100 };
+  static inline const uint32_t kDefaultFrequency{ 440 };
+  static inline const int16_t kDefaultAmplitude{ 6000 };
+
+  explicit ToneGenerator(uint32_t sample_rate = kDefaultSampleRate, uint32_t frequency = kDefaultFrequency,
+                         int16_t amplitude = kDefaultAmplitude);
+
+  // Any thread. Starts a tone `ticks` periods of the 60 Hz timer clock long, replacing whatever is left of
+  // the current one; 0 silences it.
+  void Beep(uint8_t ticks) { pending_.store(kPending | ticks, std::memory_order_release); }
+
+  // Audio thread. Renders the next `samples.size()` samples of mono audio. A beep requested since the last
+  // call starts at the first of them.
+  void Generate(std::span<int16_t> samples);
+
+  uint32_t SampleRate() const { return sample_rate_; }
+
+ private:
+  // Set in `pending_` while it holds a beep Generate has not started yet.
+  static inline const uint32_t kPending{ 0x100 };
+
+  uint32_t sample_rate_;
+  uint32_t frequency_;
+  int16_t amplitude_;
+  std::atomic<uint32_t> pending_{ 0 };
+  // Samples left of the current tone, and the position of the next sample within one second of the wave.
+  uint64_t remaining_{ 0 };
+  uint32_t phase_{ 0 };
+};
+
+}  // namespace chip8
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace chip8 {
+
+// Lock-free single producer, single consumer handoff of the latest value. The writer fills a back slot and
+// publishes it by swapping it with the middle slot; the reader swaps the middle slot with its front slot
+// whenever a fresh value is waiting. Neither side ever blocks the other: values the reader never got to are
+// overwritten, and the reader keeps its front value until a newer one is published.
+template <typename T>
+class TripleBuffer {
+ public:
+  // Writer side. The back slot stays private to the writer until Publish.
+  T& Back() { return slots_[back_]; }
+  void Publish() { back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask; }
+
+  // Reader side. Makes the most recently published value the front one, returning false if nothing was
+  // published since the last call.
+  bool Acquire() {
+    if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+  const T& Front() const { return slots_[front_]; }
+
+ private:
+  static inline const uint8_t kIndexMask{ 0x3 };
+  // Set in `middle_` while its slot holds a value the reader has not acquired.
+  static inline const uint8_t kFresh{ 0x4 };
+
+  std::array<T, 3> slots_{};
+  uint8_t back_{ 0 };
+  uint8_t front_{ 1 };
+  std::atomic<uint8_t> middle_{ 2 };
+};
+
+}  // namespace chip8
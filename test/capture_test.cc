@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "capture.h"
+#include "emulator.h"
+#include "framebuffer.h"
+#include "headless.h"
+#include "quirks.h"
+
+namespace chip8 {
+namespace {
+
+const std::string kRom{ std::string{ CHIP8_PROGRAMS_DIR } + "/Trip8Demo.ch8" };
+const uint64_t kFrames{ 300 };
+
+struct Stored {
+  uint64_t frame;
+  Framebuffer framebuffer;
+};
+
+// Runs kRom headless for kFrames frames, switching to high resolution for the middle third, and writes every
+// drawn frame to `sinks`. Returns the frames a CaptureWriter stores: those showing a new picture.
+std::vector<Stored> CaptureRun(const std::vector<FrameSink*>& sinks) {
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  BasicEmulator<kSuperChipQuirks> emulator{ kRom, screen, speaker, keyboard };
+
+  std::vector<Stored> stored;
+  size_t draws{ 0 };
+  for (uint64_t frame = 0; frame < kFrames; ++frame) {
+    if (frame == kFrames / 3) emulator.ExecuteOpcode(0x00FF);
+    if (frame == 2 * kFrames / 3) emulator.ExecuteOpcode(0x00FE);
+    emulator.RunFrame();
+    if (screen.DrawCount() == draws) continue;
+
+    draws = screen.DrawCount();
+    for (FrameSink* sink : sinks) sink->Write(frame, screen.Frame());
+    const Framebuffer& previous{ stored.empty() ? Framebuffer{} : stored.back().framebuffer };
+    if (screen.Frame() != previous) stored.push_back({ frame, screen.Frame() });
+  }
+  for (FrameSink* sink : sinks) sink->Close(kFrames);
+  return stored;
+}
+
+TEST(CaptureTest, ReaderReproducesEveryStoredFrame) {
+  std::stringstream stream;
+  CaptureWriter writer{ stream };
+  const std::vector<Stored> expected{ CaptureRun({ &writer }) };
+  EXPECT_EQ(writer.RecordCount(), expected.size());
+
+  std::set<bool> resolutions;
+  CaptureReader reader{ stream };
+  for (const Stored& frame : expected) {
+    const std::optional<CapturedFrame> captured{ reader.Next() };
+    ASSERT_TRUE(captured.has_value());
+    EXPECT_EQ(captured->frame, frame.frame);
+    EXPECT_EQ(HashFramebuffer(captured->framebuffer), HashFramebuffer(frame.framebuffer)) << frame.frame;
+    EXPECT_EQ(captured->framebuffer.hires, frame.framebuffer.hires) << frame.frame;
+    resolutions.insert(captured->framebuffer.hires);
+  }
+  EXPECT_FALSE(reader.Next().has_value());
+  EXPECT_EQ(reader.Frames(), kFrames);
+  EXPECT_EQ(resolutions.size(), 2u) << "the run never switched resolution";
+}
+
+TEST(CaptureTest, RawFramesMatchTheCapture) {
+  std::stringstream raw;
+  RawFrameWriter writer{ raw };
+  const std::vector<Stored> expected{ CaptureRun({ &writer }) };
+  const std::string pixels{ raw.str() };
+  ASSERT_EQ(pixels.size(), kFrames * RawFrameWriter::kFrameSize);
+
+  for (const Stored& frame : expected) {
+    const Framebuffer& framebuffer{ frame.framebuffer };
+    const size_t scale{ kFramebufferWidth / framebuffer.Width() };
+    for (size_t y = 0; y < kFramebufferHeight; ++y) {
+      for (size_t x = 0; x < kFramebufferWidth; ++x) {
+        const uint8_t pixel{ static_cast<uint8_t>(
+            pixels[frame.frame * RawFrameWriter::kFrameSize + y * kFramebufferWidth + x]) };
+        ASSERT_EQ(pixel, IsPixelSet(framebuffer, x / scale, y / scale) ? 255 : 0)
+            << frame.frame << " " << x << "," << y;
+      }
+    }
+  }
+}
+
+TEST(CaptureTest, ReaderRejectsTruncatedStreams) {
+  std::stringstream stream;
+  CaptureWriter writer{ stream };
+  CaptureRun({ &writer });
+  const std::string encoded{ stream.str() };
+
+  for (size_t size = 0; size < encoded.size(); size += 7) {
+    std::istringstream truncated{ encoded.substr(0, size) };
+    EXPECT_THROW(
+        {
+          CaptureReader reader{ truncated };
+          while (reader.Next().has_value()) {
+          }
+        },
+        std::invalid_argument)
+        << size;
+  }
+}
+
+}  // namespace
+}  // namespace chip8
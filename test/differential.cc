@@ -0,0 +1,345 @@
+#include "differential.h"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+#include "headless.h"
+#include "lockstep.h"
+#include "machine_state.h"
+#include "operations.h"
+#include "quirks.h"
+#include "save_state.h"
+
+namespace chip8 {
+
+namespace {
+
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+  return x ^ (x >> 31);
+}
+
+std::string DifferingFields(const MachineState& expected, const MachineState& actual) {
+  std::string fields;
+#define CHIP8_COMPARE_FIELD(field)                   \
+  if (expected.field != actual.field) {              \
+    fields += fields.empty() ? #field : ", " #field; \
+  }
+  CHIP8_COMPARE_FIELD(variable_registers)
+  CHIP8_COMPARE_FIELD(stack)
+  CHIP8_COMPARE_FIELD(stack_pointer)
+  CHIP8_COMPARE_FIELD(program_counter)
+  CHIP8_COMPARE_FIELD(index_register)
+  CHIP8_COMPARE_FIELD(delay_timer)
+  CHIP8_COMPARE_FIELD(sound_timer)
+  CHIP8_COMPARE_FIELD(memory)
+  CHIP8_COMPARE_FIELD(framebuffer)
+  CHIP8_COMPARE_FIELD(random_state)
+  CHIP8_COMPARE_FIELD(key_wait_register)
+#undef CHIP8_COMPARE_FIELD
+  return fields;
+}
+
+// What went wrong in a frame or step, empty if the engines agree.
+std::string Compare(const MachineState& expected, const std::optional<std::string>& expected_error,
+                    const MachineState& actual, const std::optional<std::string>& actual_error) {
+  if (expected_error != actual_error) {
+    const auto outcome{ [](const std::optional<std::string>& error) {
+      return error ? "threw '" + *error + "'" : std::string{ "ran" };
+    } };
+    return fmt::format("interpreter {}, engine {}", outcome(expected_error), outcome(actual_error));
+  }
+  return DifferingFields(expected, actual);
+}
+
+// Runs `step` and returns the message of whatever it threw.
+template <typename Step>
+std::optional<std::string> CatchError(Step&& step) {
+  try {
+    step();
+  } catch (const std::exception& e) {
+    return e.what();
+  }
+  return std::nullopt;
+}
+
+// An emulator driven by a MemoryKeyboard, with the devices it needs.
+template <Quirks kQuirks>
+struct EmulatorLane {
+  EmulatorLane(const std::string& rom, const SaveState& state, EmulatorBase::Engine engine,
+               uint32_t clock_speed)
+      : emulator{ rom, screen, speaker, keyboard, clock_speed, EmulatorBase::Mode::kTurbo, engine } {
+    emulator.Restore(state);
+  };
+
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  BasicEmulator<kQuirks> emulator;
+  std::optional<std::string> error;
+};
+
+struct Candidate {
+  const char* name;
+  EmulatorBase::Engine engine;
+};
+
+constexpr Candidate kCandidates[]{
+  { "predecoded", EmulatorBase::Engine::kPredecoded },
+  { "blocks", EmulatorBase::Engine::kBlocks },
+};
+
+constexpr const char* kLockstepName{ "lockstep" };
+
+template <Quirks kQuirks>
+class Differential {
+ public:
+  Differential(const std::string& rom, const SaveState& initial, const DifferentialOptions& options)
+      : rom_{ rom }, initial_{ initial }, options_{ options } {};
+
+  DifferentialResult Run();
+
+ private:
+  void Localize(Divergence& divergence) const;
+
+  const std::string& rom_;
+  const SaveState& initial_;
+  const DifferentialOptions& options_;
+};
+
+template <Quirks kQuirks>
+DifferentialResult Differential<kQuirks>::Run() {
+  std::vector<std::unique_ptr<EmulatorLane<kQuirks>>> references;
+  // Indexed [lane * candidates + candidate].
+  std::vector<std::unique_ptr<EmulatorLane<kQuirks>>> candidates;
+  for (size_t lane = 0; lane < options_.lanes; ++lane) {
+    references.push_back(std::make_unique<EmulatorLane<kQuirks>>(
+        rom_, initial_, EmulatorBase::Engine::kInterpreter, options_.clock_speed));
+    for (const Candidate& candidate : kCandidates) {
+      candidates.push_back(
+          std::make_unique<EmulatorLane<kQuirks>>(rom_, initial_, candidate.engine, options_.clock_speed));
+    }
+  }
+
+  // The lockstep engine implements kModernQuirks only, and runs all lanes at once until one of them throws.
+  std::unique_ptr<LockstepEngine> lockstep;
+  if constexpr (kQuirks == kModernQuirks) {
+    lockstep = std::make_unique<LockstepEngine>(references[0]->emulator.CaptureState(), options_.lanes,
+                                                options_.clock_speed);
+  }
+
+  DifferentialResult result;
+  const auto diverge{ [&](const char* engine, size_t lane, uint64_t frame, std::string difference) {
+    result.divergence = { .engine = engine, .lane = lane, .frame = frame, .difference = difference };
+    Localize(*result.divergence);
+    return result;
+  } };
+
+  for (uint64_t frame = 0; frame < options_.frames; ++frame) {
+    bool running{ false };
+    bool threw{ false };
+    std::optional<std::string> lockstep_error;
+    if (lockstep) {
+      for (size_t lane = 0; lane < options_.lanes; ++lane) {
+        lockstep->SetKeys(lane, ScriptedKeys(options_.key_seed, lane, frame));
+      }
+      lockstep_error = CatchError([&] { lockstep->RunFrame(); });
+    }
+
+    for (size_t lane = 0; lane < options_.lanes; ++lane) {
+      EmulatorLane<kQuirks>& reference{ *references[lane] };
+      if (reference.error) continue;
+
+      const uint16_t keys{ ScriptedKeys(options_.key_seed, lane, frame) };
+      const uint64_t start{ reference.emulator.Cycles() };
+      reference.keyboard.SetKeys(keys);
+      reference.error = CatchError([&] { reference.emulator.RunFrame(); });
+      result.cycles += reference.emulator.Cycles() - start;
+      running |= !reference.error;
+      threw |= reference.error.has_value();
+      const MachineState expected{ reference.emulator.CaptureState() };
+
+      for (size_t i = 0; i < std::size(kCandidates); ++i) {
+        EmulatorLane<kQuirks>& candidate{ *candidates[lane * std::size(kCandidates) + i] };
+        candidate.keyboard.SetKeys(keys);
+        candidate.error = CatchError([&] { candidate.emulator.RunFrame(); });
+        const std::string difference{ Compare(expected, reference.error, candidate.emulator.CaptureState(),
+                                              candidate.error) };
+        if (!difference.empty()) return diverge(kCandidates[i].name, lane, frame, difference);
+      }
+
+      if (lockstep && !lockstep_error) {
+        const std::string difference{ Compare(expected, reference.error, lockstep->CaptureState(lane),
+                                              std::nullopt) };
+        if (!difference.empty()) return diverge(kLockstepName, lane, frame, difference);
+      }
+    }
+
+    // An error stops every lane of the lockstep engine wherever it was, so all that can be checked is that
+    // some lane threw in the same frame.
+    if (lockstep_error) {
+      if (!threw) {
+        return diverge(kLockstepName, 0, frame, "interpreter ran, engine threw '" + *lockstep_error + "'");
+      }
+      lockstep.reset();
+    }
+    if (!running) break;
+  }
+  return result;
+};
+
+// Replays the lane up to the diverging frame with a fresh interpreter, then steps it and a fresh copy of the
+// engine from there one instruction at a time.
+template <Quirks kQuirks>
+void Differential<kQuirks>::Localize(Divergence& divergence) const {
+  EmulatorLane<kQuirks> reference{ rom_, initial_, EmulatorBase::Engine::kInterpreter, options_.clock_speed };
+  for (uint64_t frame = 0; frame < divergence.frame; ++frame) {
+    reference.keyboard.SetKeys(ScriptedKeys(options_.key_seed, divergence.lane, frame));
+    reference.emulator.RunFrame();
+  }
+  const uint16_t keys{ ScriptedKeys(options_.key_seed, divergence.lane, divergence.frame) };
+  reference.keyboard.SetKeys(keys);
+
+  std::unique_ptr<EmulatorLane<kQuirks>> engine;
+  std::unique_ptr<LockstepEngine> lockstep;
+  if (divergence.engine == kLockstepName) {
+    lockstep = std::make_unique<LockstepEngine>(reference.emulator.CaptureState(), 1, options_.clock_speed);
+    lockstep->SetKeys(0, keys);
+  } else {
+    const SaveState start{ reference.emulator.Snapshot() };
+    for (const Candidate& candidate : kCandidates) {
+      if (divergence.engine == candidate.name) {
+        engine = std::make_unique<EmulatorLane<kQuirks>>(rom_, start, candidate.engine, options_.clock_speed);
+        engine->keyboard.SetKeys(keys);
+      }
+    }
+  }
+
+  // A frame is exactly clock_speed / 60 cycles.
+  for (uint32_t step = 0; step < options_.clock_speed / EmulatorBase::kChip8TimerFrequency; ++step) {
+    const MachineState before{ reference.emulator.CaptureState() };
+    const uint64_t cycle{ reference.emulator.Cycles() };
+
+    const std::optional<std::string> expected_error{ CatchError([&] { reference.emulator.Step(); }) };
+    std::optional<std::string> actual_error;
+    MachineState actual;
+    if (lockstep) {
+      actual_error = CatchError([&] { lockstep->Step(); });
+      actual = lockstep->CaptureState(0);
+    } else {
+      actual_error = CatchError([&] { engine->emulator.Step(); });
+      actual = engine->emulator.CaptureState();
+    }
+
+    if (!Compare(reference.emulator.CaptureState(), expected_error, actual, actual_error).empty()) {
+      constexpr uint16_t kAddressMask{ EmulatorBase::kChip8MemorySize - 1 };
+      const uint16_t pc{ before.program_counter };
+      divergence.cycle = cycle;
+      divergence.program_counter = pc;
+      divergence.opcode = static_cast<uint16_t>(before.memory[pc & kAddressMask] << 8 |
+                                                before.memory[(pc + 1) & kAddressMask]);
+      return;
+    }
+    if (expected_error) return;
+  }
+};
+
+}  // namespace
+
+std::string Divergence::Describe() const {
+  std::string description{ fmt::format("{} engine, lane {}, frame {}: {}", engine, lane, frame, difference) };
+  if (cycle.has_value()) {
+    const Operation operation{ kOperationTable[opcode] };
+    description += fmt::format("; first differs after {:04X} ({}) at {:03X} on cycle {}", opcode,
+                               kOperationNames[static_cast<size_t>(operation)], program_counter, *cycle);
+  } else {
+    description += "; stepping the frame one instruction at a time agrees";
+  }
+  return description;
+};
+
+uint16_t ScriptedKeys(uint64_t seed, size_t lane, uint64_t frame) {
+  const uint64_t random{ SplitMix64(SplitMix64(seed ^ (static_cast<uint64_t>(lane) << 48)) + frame / 8) };
+  if (random & 1) return 0;
+  return static_cast<uint16_t>((1 << ((random >> 1) & 0xF)) | ((random >> 5) & 1) << ((random >> 6) & 0xF));
+};
+
+void FillRandomProgram(SaveState& state, uint64_t seed) {
+  constexpr uint16_t kCodeStart{ EmulatorBase::kChip8ProgramStartAddress };
+  constexpr uint16_t kDataStart{ 0xE00 };
+  // BNNN adds up to 0xFF to its target, which must still be code.
+  constexpr uint16_t kJumpEnd{ kDataStart - 0x100 };
+
+  uint64_t random{ seed };
+  for (uint16_t address = kCodeStart; address < kDataStart; address += 2) {
+    uint16_t raw;
+    Operation operation;
+    do {
+      random = SplitMix64(random);
+      raw = static_cast<uint16_t>(random);
+      operation = kOperationTable[raw];
+    } while (operation == Operation::kUnknown || operation == Operation::kCallSubroutine ||
+             operation == Operation::kReturnFromSubroutine ||
+             // Half of these land on an odd address, where the code decodes as garbage, so they are rare.
+             (operation == Operation::kJumpWithOffset && (random >> 16) % 16 != 0));
+
+    const uint16_t target{ static_cast<uint16_t>((random >> 32) % 0x1000) };
+    if (operation == Operation::kJump || operation == Operation::kJumpWithOffset) {
+      raw = static_cast<uint16_t>((raw & 0xF000) | ((kCodeStart + target % (kJumpEnd - kCodeStart)) & ~1));
+    } else if (operation == Operation::kSetIndexRegister) {
+      raw = static_cast<uint16_t>((raw & 0xF000) | (kDataStart + target % (0x1000 - kDataStart)));
+    }
+    state.memory[address] = static_cast<uint8_t>(raw >> 8);
+    state.memory[address + 1] = static_cast<uint8_t>(raw & 0xFF);
+  }
+  // Execution running off the end of the code starts over instead of running into the data.
+  state.memory[kDataStart - 2] = static_cast<uint8_t>(0x10 | (kCodeStart >> 8));
+  state.memory[kDataStart - 1] = static_cast<uint8_t>(kCodeStart & 0xFF);
+
+  for (uint16_t address = kDataStart; address < EmulatorBase::kChip8MemorySize; ++address) {
+    random = SplitMix64(random);
+    state.memory[address] = static_cast<uint8_t>(random);
+  }
+};
+
+SaveState LoadProgram(const std::string& rom, uint64_t seed) {
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  Emulator emulator{ rom, screen, speaker, keyboard };
+  emulator.Seed(seed);
+  return emulator.Snapshot();
+};
+
+template <Quirks kQuirks>
+DifferentialResult RunDifferential(const std::string& rom, const SaveState& initial,
+                                   const DifferentialOptions& options) {
+  if (options.lanes == 0 || options.clock_speed == 0 ||
+      options.clock_speed % EmulatorBase::kChip8TimerFrequency != 0) {
+    throw std::invalid_argument{ "differential runs need lanes and a clock speed that is a multiple of 60" };
+  }
+  if (initial.cycles != 0) {
+    throw std::invalid_argument{ "differential runs must start at cycle 0" };
+  }
+  return Differential<kQuirks>{ rom, initial, options }.Run();
+};
+
+#define CHIP8_INSTANTIATE_RUN_DIFFERENTIAL(profile, name)                                   \
+  template DifferentialResult RunDifferential<profile>(const std::string& rom, const SaveState& initial, \
+                                                       const DifferentialOptions& options);
+CHIP8_QUIRK_PROFILES(CHIP8_INSTANTIATE_RUN_DIFFERENTIAL)
+#undef CHIP8_INSTANTIATE_RUN_DIFFERENTIAL
+
+}  // namespace chip8
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "quirks.h"
+#include "save_state.h"
+
+namespace chip8 {
+
+// Differential harness: runs one program on every engine and checks each of them against the interpreter,
+// which serves as the reference model. Whatever dispatch the core was built with (CHIP8_DISPATCH) is the
+// one under test.
+//
+// A run has several lanes, each a copy of the program driven by its own scripted keypad. Per lane, the
+// predecoded and block engines and, for kModernQuirks, a LockstepEngine lane step a frame at a time next
+// to a reference interpreter, and after every frame their full machine states are compared, framebuffer
+// and memory included. At the first disagreement the frame is replayed from the reference's state at its
+// start one instruction at a time, to find the instruction after which the engines first differ.
+
+struct DifferentialOptions {
+  size_t lanes{ 4 };
+  uint64_t frames{ 600 };
+  // Seeds the keypad script of every lane.
+  uint64_t key_seed{ 0 };
+  // Instructions per emulated second. Must be a multiple of 60, so every frame starts on the cycle a
+  // LockstepEngine built from the frame's state would start on.
+  uint32_t clock_speed{ 60000 };
+};
+
+struct Divergence {
+  std::string engine;
+  size_t lane;
+  uint64_t frame;
+  // Names of the machine state fields that differ, or the error one side threw and the other did not.
+  std::string difference;
+  // The first instruction after which the engine and the interpreter disagree, and the cycle it ran on.
+  // Unset when replaying the frame one instruction at a time agrees. That happens when only a whole-frame
+  // path such as the block engine's goes wrong, or with a lockstep lane that only goes wrong next to other
+  // lanes, since the replay runs a single lane.
+  std::optional<uint64_t> cycle{};
+  uint16_t program_counter{ 0 };
+  uint16_t opcode{ 0 };
+
+  std::string Describe() const;
+};
+
+struct DifferentialResult {
+  // Cycles run by the reference interpreters, summed over lanes.
+  uint64_t cycles{ 0 };
+  std::optional<Divergence> divergence;
+};
+
+// Keypad of `lane` in `frame`: held for 8 frames at a time, released half of the time so FX0A waits keep
+// resolving, otherwise one or two keys.
+uint16_t ScriptedKeys(uint64_t seed, size_t lane, uint64_t frame);
+
+// Fills the program area of `state` with random code followed by random data at 0xE00. The code uses every
+// operation except calls, returns and invalid opcodes; 1NNN and BNNN jump into the code and ANNN points
+// into the data, so a program mostly runs until what it stores through I lands in the code and decodes as
+// an invalid opcode.
+void FillRandomProgram(SaveState& state, uint64_t seed);
+
+// State of `rom` right after loading, with its random sequence seeded from `seed`.
+SaveState LoadProgram(const std::string& rom, uint64_t seed);
+
+// Runs the program in `initial`, which must be at cycle 0, on every engine. `rom` is only loaded to
+// construct the emulators before they are restored to `initial`. Instantiated for every profile in
+// CHIP8_QUIRK_PROFILES.
+template <Quirks kQuirks>
+DifferentialResult RunDifferential(const std::string& rom, const SaveState& initial,
+                                   const DifferentialOptions& options);
+
+}  // namespace chip8
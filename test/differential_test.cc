@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "differential.h"
+#include "quirks.h"
+#include "save_state.h"
+
+namespace chip8 {
+namespace {
+
+const std::string kProgramsDir{ CHIP8_PROGRAMS_DIR };
+
+// Every run is kept short by default. CI covers billions of cycles by raising CHIP8_DIFFERENTIAL_FRAMES and
+// CHIP8_DIFFERENTIAL_PROGRAMS, each frame being DifferentialOptions::clock_speed / 60 cycles per lane.
+uint64_t EnvironmentOr(const char* name, uint64_t fallback) {
+  const char* value{ std::getenv(name) };
+  return value != nullptr ? std::stoull(value) : fallback;
+}
+
+DifferentialOptions Options(uint64_t key_seed) {
+  return { .frames = EnvironmentOr("CHIP8_DIFFERENTIAL_FRAMES", 300), .key_seed = key_seed };
+}
+
+std::vector<std::string> Roms() {
+  std::vector<std::string> roms;
+  for (const auto& entry : std::filesystem::directory_iterator{ kProgramsDir }) {
+    if (entry.path().extension() == ".ch8") roms.push_back(entry.path().filename().string());
+  }
+  std::sort(roms.begin(), roms.end());
+  return roms;
+}
+
+// Runs `initial` under every quirks profile.
+void ExpectEnginesAgree(const std::string& rom, const SaveState& initial, uint64_t key_seed) {
+  uint64_t cycles{ 0 };
+#define CHIP8_EXPECT_ENGINES_AGREE(profile, name)                                               \
+  {                                                                                             \
+    const DifferentialResult result{ RunDifferential<profile>(rom, initial, Options(key_seed)) }; \
+    cycles += result.cycles;                                                                    \
+    EXPECT_FALSE(result.divergence.has_value()) << name << ": " << result.divergence->Describe(); \
+  }
+  CHIP8_QUIRK_PROFILES(CHIP8_EXPECT_ENGINES_AGREE)
+#undef CHIP8_EXPECT_ENGINES_AGREE
+  testing::Test::RecordProperty("cycles", std::to_string(cycles));
+}
+
+class RomDifferentialTest : public testing::TestWithParam<std::string> {};
+
+TEST_P(RomDifferentialTest, EnginesAgreeWithInterpreter) {
+  const std::string rom{ kProgramsDir + "/" + GetParam() };
+  ExpectEnginesAgree(rom, LoadProgram(rom, 1), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Programs, RomDifferentialTest, testing::ValuesIn(Roms()),
+                         [](const testing::TestParamInfo<std::string>& info) {
+                           std::string name{ std::filesystem::path{ info.param }.stem().string() };
+                           std::replace_if(
+                               name.begin(), name.end(), [](char c) { return !std::isalnum(c); }, '_');
+                           return name;
+                         });
+
+class RandomProgramDifferentialTest : public testing::TestWithParam<uint64_t> {};
+
+TEST_P(RandomProgramDifferentialTest, EnginesAgreeWithInterpreter) {
+  // Any ROM will do: the whole program area is overwritten.
+  const std::string rom{ kProgramsDir + "/LogoIBM.ch8" };
+  SaveState initial{ LoadProgram(rom, GetParam()) };
+  FillRandomProgram(initial, GetParam());
+  ExpectEnginesAgree(rom, initial, GetParam());
+}
+
+INSTANTIATE_TEST_SUITE_P(Seeds, RandomProgramDifferentialTest,
+                         testing::Range<uint64_t>(0, EnvironmentOr("CHIP8_DIFFERENTIAL_PROGRAMS", 16)));
+
+}  // namespace
+}  // namespace chip8
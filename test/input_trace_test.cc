@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+#include "framebuffer.h"
+#include "headless.h"
+#include "input_trace.h"
+
+namespace chip8 {
+namespace {
+
+const std::string kRom{ std::string{ CHIP8_PROGRAMS_DIR } + "/Brix.ch8" };
+const InputTrace::Setup kSetup{ .seed = 1234, .clock_speed = 900, .quirks = "modern" };
+const uint64_t kFrames{ 600 };
+
+// `kRom` run under kSetup with `keyboard`. RunFrames returns the framebuffer hashes of every frame chained
+// into one value.
+struct Session {
+  explicit Session(Keyboard& keyboard) : emulator{ kRom, screen, speaker, keyboard, kSetup.clock_speed } {
+    emulator.Seed(kSetup.seed);
+  }
+
+  uint64_t RunFrames(MemoryKeyboard* live) {
+    uint64_t hash{ kFramebufferHashSeed };
+    for (uint64_t frame = 0; frame < kFrames; ++frame) {
+      // Holds left or right for a while at a time, then lets go.
+      if (live != nullptr) live->SetKeys(frame / 45 % 3 == 0 ? 1 << 4 : frame / 45 % 3 == 1 ? 1 << 6 : 0);
+      emulator.RunFrame();
+      hash = HashFramebuffer(screen.Frame(), hash);
+    }
+    return hash;
+  }
+
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  Emulator emulator;
+};
+
+TEST(InputTraceTest, EncodeDecodeRoundTripsSetupAndEvents) {
+  InputTrace trace;
+  trace.SetSetup(kSetup);
+  trace.Append({ .frame = 0, .kind = InputTrace::Kind::kKeys, .value = 0x0010 });
+  trace.Append({ .frame = 300, .kind = InputTrace::Kind::kKeys, .value = 0x8001 });
+
+  const InputTrace decoded{ InputTrace::Decode(trace.Encode()) };
+  EXPECT_EQ(decoded.GetSetup(), kSetup);
+  EXPECT_EQ(decoded.Events(), trace.Events());
+}
+
+TEST(InputTraceTest, EncodeNeedsASetup) { EXPECT_THROW(InputTrace{}.Encode(), std::invalid_argument); }
+
+TEST(InputTraceTest, DecodeRejectsOtherVersionsAndTruncatedTraces) {
+  InputTrace trace;
+  trace.SetSetup(kSetup);
+  trace.Append({ .frame = 5, .kind = InputTrace::Kind::kKeys, .value = 0x0010 });
+  std::vector<uint8_t> encoded{ trace.Encode() };
+
+  for (size_t size = 0; size < encoded.size(); ++size) {
+    // Cutting off whole events leaves a valid, shorter trace.
+    if (size == encoded.size() - 4) continue;
+    EXPECT_THROW(InputTrace::Decode(std::span{ encoded }.first(size)), std::invalid_argument) << size;
+  }
+
+  encoded[4] = InputTrace::kVersion - 1;
+  EXPECT_THROW(InputTrace::Decode(encoded), std::invalid_argument);
+}
+
+TEST(InputTraceTest, ReplayReproducesTheRecordedRun) {
+  MemoryKeyboard live;
+  InputTrace trace;
+  trace.SetSetup(kSetup);
+  InputRecorder recorder{ live, trace };
+  Session recorded{ recorder };
+  const uint64_t recorded_hash{ recorded.RunFrames(&live) };
+  ASSERT_GT(trace.Events().size(), 2u);
+
+  const InputTrace loaded{ InputTrace::Decode(trace.Encode()) };
+  InputPlayer player{ loaded, kSetup };
+  Session replayed{ player };
+  EXPECT_EQ(replayed.RunFrames(nullptr), recorded_hash);
+  EXPECT_EQ(replayed.emulator.CaptureState(), recorded.emulator.CaptureState());
+
+  // The input mattered, so the replay did not just agree by accident.
+  MemoryKeyboard idle;
+  EXPECT_NE(Session{ idle }.RunFrames(nullptr), recorded_hash);
+}
+
+TEST(InputTraceTest, PlayerRejectsAnotherSetup) {
+  InputTrace trace;
+  trace.SetSetup(kSetup);
+
+  InputTrace::Setup seed{ kSetup };
+  seed.seed += 1;
+  EXPECT_THROW(InputPlayer(trace, seed), std::invalid_argument);
+
+  InputTrace::Setup clock_speed{ kSetup };
+  clock_speed.clock_speed = Emulator::kChip8DefaultClockSpeed;
+  EXPECT_THROW(InputPlayer(trace, clock_speed), std::invalid_argument);
+
+  InputTrace::Setup quirks{ kSetup };
+  quirks.quirks = "vip";
+  EXPECT_THROW(InputPlayer(trace, quirks), std::invalid_argument);
+
+  // A trace without a setup, such as an empty one, constrains nothing.
+  EXPECT_NO_THROW(InputPlayer(InputTrace{}, seed));
+}
+
+}  // namespace
+}  // namespace chip8
@@ -0,0 +1,202 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+#include "framebuffer.h"
+#include "headless.h"
+#include "quirks.h"
+#include "remote.h"
+
+namespace chip8 {
+namespace {
+
+// A minute of play, long enough for the games to settle into their usual traffic.
+const uint64_t kFrames{ 60 * 60 };
+// What a typical game may cost a client. Pong, which moves its ball every frame, is the busiest of those
+// below at about 620; the rest stay near 200.
+const double kMaxBytesPerSecond{ 750 };
+
+// Client end of a loopback connection to a RemoteScreen, decoding every message as it arrives.
+class Client {
+ public:
+  explicit Client(uint16_t port) {
+    socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (socket_ < 0 ||
+        ::connect(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+      throw std::runtime_error{ "Error connecting to the remote screen" };
+    }
+  }
+  ~Client() { ::close(socket_); }
+
+  // Decodes whatever has arrived so far.
+  void Receive() {
+    std::array<uint8_t, 4096> buffer;
+    ssize_t received;
+    while ((received = ::recv(socket_, buffer.data(), buffer.size(), MSG_DONTWAIT)) > 0) {
+      pending_.insert(pending_.end(), buffer.begin(), buffer.begin() + received);
+      received_ += static_cast<uint64_t>(received);
+    }
+    size_t size;
+    while ((size = decoder_.Decode(pending_)) > 0) {
+      pending_.erase(pending_.begin(), pending_.begin() + static_cast<ptrdiff_t>(size));
+      ++messages_;
+    }
+  }
+
+  const RemoteFrameDecoder& Decoder() const { return decoder_; }
+  uint64_t Received() const { return received_; }
+  size_t Messages() const { return messages_; }
+
+ private:
+  int socket_{ -1 };
+  RemoteFrameDecoder decoder_;
+  std::vector<uint8_t> pending_;
+  uint64_t received_{ 0 };
+  size_t messages_{ 0 };
+};
+
+struct Session {
+  uint64_t bytes;
+  size_t messages;
+};
+
+// Runs `rom` headless for kFrames frames with a key held down in turn for a third of a second each, forwards
+// every drawn frame through a RemoteScreen, and checks the client's picture after every frame. Calls
+// `before_frame` with the emulator ahead of each one.
+template <const Quirks& kQuirks, typename BeforeFrame>
+Session RunSession(const std::string& rom, BeforeFrame before_frame) {
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  BasicEmulator<kQuirks> emulator{ std::string{ CHIP8_PROGRAMS_DIR } + "/" + rom, screen, speaker, keyboard };
+  emulator.Seed(1);
+
+  RemoteScreen remote{ 0 };
+  Client client{ remote.Port() };
+  remote.Accept();
+
+  for (uint64_t frame = 0; frame < kFrames; ++frame) {
+    keyboard.SetKeys(static_cast<uint16_t>(1 << ((frame / 20) % 16)));
+    before_frame(emulator, frame);
+    emulator.RunFrame();
+    remote.Draw(screen.Frame());
+    EXPECT_TRUE(remote.IsOpen());
+    client.Receive();
+
+    const Framebuffer& decoded{ client.Decoder().Frame() };
+    EXPECT_EQ(decoded.hires, screen.Frame().hires) << rom << " frame " << frame;
+    EXPECT_EQ(HashFramebuffer(decoded), HashFramebuffer(screen.Frame())) << rom << " frame " << frame;
+    if (decoded != screen.Frame()) break;
+  }
+  EXPECT_EQ(client.Received(), remote.BytesSent());
+  return { remote.BytesSent(), client.Messages() };
+}
+
+template <const Quirks& kQuirks>
+Session RunSession(const std::string& rom) {
+  return RunSession<kQuirks>(rom, [](auto&, uint64_t) {});
+}
+
+class RemoteGameTest : public testing::TestWithParam<std::string> {};
+
+TEST_P(RemoteGameTest, ClientSeesEveryFrameWithinBandwidth) {
+  const Session session{ RunSession<kModernQuirks>(GetParam()) };
+  const double bytes_per_second{ static_cast<double>(session.bytes) / (static_cast<double>(kFrames) / 60) };
+  RecordProperty("bytes_per_second", std::to_string(bytes_per_second));
+  EXPECT_GT(session.messages, 0u);
+  EXPECT_LE(bytes_per_second, kMaxBytesPerSecond) << GetParam();
+}
+
+INSTANTIATE_TEST_SUITE_P(Games, RemoteGameTest, testing::Values("Pong.ch8", "Brix.ch8", "Tetris.ch8",
+                                                                "SpaceInvaders.ch8", "Breakout.ch8"));
+
+TEST(RemoteTest, ClientFollowsResolutionSwitches) {
+  // Trip8Demo redraws the whole screen every frame, so it is no bandwidth yardstick; it is here for the
+  // switches to high resolution and back.
+  RunSession<kSuperChipQuirks>("Trip8Demo.ch8", [](auto& emulator, uint64_t frame) {
+    if (frame == kFrames / 3) emulator.ExecuteOpcode(0x00FF);
+    if (frame == 2 * kFrames / 3) emulator.ExecuteOpcode(0x00FE);
+  });
+}
+
+TEST(RemoteTest, UnchangedFrameSendsNothing) {
+  RemoteFrameEncoder encoder;
+  std::vector<uint8_t> out;
+  encoder.Encode(Framebuffer{}, std::nullopt, out);
+  EXPECT_TRUE(out.empty());
+
+  Framebuffer frame{};
+  frame.left[5] = 0x00F0000000000000;
+  encoder.Encode(frame, std::nullopt, out);
+  // Length, tag, first and last row, the span's row mask, the row's byte mask and the one changed byte.
+  EXPECT_EQ(out.size(), 7u);
+
+  out.clear();
+  encoder.Encode(frame, std::nullopt, out);
+  EXPECT_TRUE(out.empty());
+}
+
+TEST(RemoteTest, SoundAndBareResolutionSwitchRoundTrip) {
+  RemoteFrameEncoder encoder;
+  RemoteFrameDecoder decoder;
+  std::vector<uint8_t> out;
+
+  // Switching to a blank high resolution screen changes no rows, so the rows record is only its tag.
+  encoder.Encode(Framebuffer{ .hires = true }, uint8_t{ 4 }, out);
+  ASSERT_EQ(decoder.Decode(out), out.size());
+  EXPECT_TRUE(decoder.Frame().hires);
+  EXPECT_EQ(decoder.Beep(), uint8_t{ 4 });
+
+  out.clear();
+  Framebuffer frame{ .hires = true };
+  frame.right[63] = 0x8000000000000001;
+  encoder.Encode(frame, std::nullopt, out);
+  ASSERT_EQ(decoder.Decode(out), out.size());
+  EXPECT_EQ(decoder.Frame(), frame);
+  EXPECT_FALSE(decoder.Beep().has_value());
+}
+
+TEST(RemoteTest, DecoderWaitsForWholeMessagesAndRejectsMalformedOnes) {
+  RemoteFrameEncoder encoder;
+  Framebuffer frame{};
+  frame.left[0] = 0xFF;
+  frame.left[31] = 0xFF00000000000000;
+  std::vector<uint8_t> out;
+  encoder.Encode(frame, uint8_t{ 1 }, out);
+
+  for (size_t size = 0; size < out.size(); ++size) {
+    RemoteFrameDecoder decoder;
+    EXPECT_EQ(decoder.Decode(std::span{ out }.first(size)), 0u) << size;
+  }
+
+  // A length that no longer covers the records it claims.
+  std::vector<uint8_t> short_length{ out };
+  short_length[0] = static_cast<uint8_t>(out.size() - 2);
+  short_length.pop_back();
+  EXPECT_THROW(RemoteFrameDecoder{}.Decode(short_length), std::invalid_argument);
+
+  const std::vector<uint8_t> unknown_record{ 0x01, 0x7F };
+  EXPECT_THROW(RemoteFrameDecoder{}.Decode(unknown_record), std::invalid_argument);
+
+  const std::vector<uint8_t> row_out_of_range{ 0x05, kRemoteLowResRows, 32, 32, 0x01, 0x00 };
+  EXPECT_THROW(RemoteFrameDecoder{}.Decode(row_out_of_range), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace chip8
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "emulator.h"
+#include "framebuffer.h"
+#include "headless.h"
+#include "quirks.h"
+#include "rewind.h"
+#include "save_state.h"
+
+namespace chip8 {
+namespace {
+
+const std::string kRom{ std::string{ CHIP8_PROGRAMS_DIR } + "/Trip8Demo.ch8" };
+
+uint64_t HashSaveState(const SaveState& state) {
+  return HashFramebuffer(
+      { .left = state.framebuffer_left, .right = state.framebuffer_right, .hires = state.hires != 0 });
+}
+
+// A state differing from the one of `frame` - 1 in a handful of bytes.
+SaveState StateOfFrame(uint64_t frame) {
+  SaveState state;
+  state.timer_ticks = frame;
+  state.memory[frame % state.memory.size()] = static_cast<uint8_t>(frame | 1);
+  return state;
+}
+
+TEST(RewindBufferTest, WrapsAndEvictsOldestFramesWithinCapacity) {
+  const size_t capacity{ 256 };
+  RewindBuffer buffer{ capacity };
+  const uint64_t frames{ 200 };
+  for (uint64_t frame = 0; frame < frames; ++frame) {
+    buffer.Record(StateOfFrame(frame));
+    EXPECT_LE(buffer.Bytes(), capacity);
+  }
+
+  // Far more deltas were recorded than fit, so the ring has wrapped and dropped the oldest ones.
+  const size_t kept{ buffer.Frames() };
+  EXPECT_GT(kept, 0u);
+  EXPECT_LT(kept, frames - 1);
+
+  for (size_t back = 1; back <= kept; ++back) {
+    const std::optional<SaveState> state{ buffer.StepBack() };
+    ASSERT_TRUE(state.has_value());
+    EXPECT_EQ(*state, StateOfFrame(frames - 1 - back)) << back;
+  }
+  EXPECT_FALSE(buffer.StepBack().has_value());
+  EXPECT_EQ(buffer.Bytes(), 0u);
+}
+
+TEST(RewindBufferTest, RecordingAfterStepBackOverwritesTheUndoneFrames) {
+  RewindBuffer buffer{ 1024 };
+  for (uint64_t frame = 0; frame < 10; ++frame) {
+    buffer.Record(StateOfFrame(frame));
+  }
+  ASSERT_EQ(buffer.StepBack(), StateOfFrame(8));
+  ASSERT_EQ(buffer.StepBack(), StateOfFrame(7));
+
+  buffer.Record(StateOfFrame(100));
+  EXPECT_EQ(buffer.Frames(), 8u);
+  EXPECT_EQ(buffer.StepBack(), StateOfFrame(7));
+  EXPECT_EQ(buffer.StepBack(), StateOfFrame(6));
+}
+
+TEST(RewindBufferTest, SteppingBackReproducesEarlierFramebuffers) {
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  Emulator emulator{ kRom, screen, speaker, keyboard };
+  RewindBuffer buffer;
+  emulator.AttachRewindBuffer(&buffer);
+
+  std::vector<uint64_t> hashes{ HashSaveState(emulator.Snapshot()) };
+  for (int frame = 0; frame < 180; ++frame) {
+    emulator.RunFrame();
+    hashes.push_back(HashFramebuffer(screen.Frame()));
+  }
+  emulator.AttachRewindBuffer(nullptr);
+  ASSERT_GT(std::set<uint64_t>(hashes.begin(), hashes.end()).size(), 1u) << "the program never drew";
+  ASSERT_EQ(buffer.Frames(), hashes.size() - 1);
+
+  for (size_t back = 1; back < hashes.size(); ++back) {
+    const std::optional<SaveState> state{ buffer.StepBack() };
+    ASSERT_TRUE(state.has_value());
+    EXPECT_EQ(HashSaveState(*state), hashes[hashes.size() - 1 - back]) << back;
+
+    emulator.Restore(*state);
+    EXPECT_EQ(HashFramebuffer(emulator.CaptureState().framebuffer), hashes[hashes.size() - 1 - back]);
+  }
+}
+
+TEST(RewindBufferTest, FramesRecordedByTheEmulatorMatchItsSnapshots) {
+  // Brix writes its score to memory with FX33, the restore halfway through rewrites every page, and the
+  // switches to high resolution and back change rows the low resolution frames leave alone.
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  BasicEmulator<kSuperChipQuirks> emulator{ std::string{ CHIP8_PROGRAMS_DIR } + "/Brix.ch8", screen, speaker,
+                                            keyboard };
+  emulator.Seed(3);
+  RewindBuffer buffer;
+  emulator.AttachRewindBuffer(&buffer);
+
+  std::vector<SaveState> snapshots{ emulator.Snapshot() };
+  std::set<uint64_t> memory_hashes;
+  for (int frame = 0; frame < 600; ++frame) {
+    keyboard.SetKeys(static_cast<uint16_t>(frame % 90 < 45 ? 1 << 4 : 1 << 6));
+    if (frame == 300) emulator.Restore(snapshots[100]);
+    if (frame == 400) {
+      // Also draws a sprite at (100, 50), off the low resolution screen.
+      for (uint16_t opcode : { 0x00FF, 0x6064, 0x6132, 0xA000, 0xD015 }) emulator.ExecuteOpcode(opcode);
+    }
+    if (frame == 500) emulator.ExecuteOpcode(0x00FE);
+    emulator.RunFrame();
+    snapshots.push_back(emulator.Snapshot());
+    memory_hashes.insert(std::hash<std::string_view>{}(std::string_view{
+        reinterpret_cast<const char*>(snapshots.back().memory.data()), snapshots.back().memory.size() }));
+  }
+  emulator.AttachRewindBuffer(nullptr);
+  ASSERT_GT(memory_hashes.size(), 1u) << "the program never wrote to memory";
+  ASSERT_EQ(buffer.Frames(), snapshots.size() - 1);
+
+  for (size_t back = 1; back < snapshots.size(); ++back) {
+    const std::optional<SaveState> state{ buffer.StepBack() };
+    ASSERT_TRUE(state.has_value());
+    ASSERT_EQ(*state, snapshots[snapshots.size() - 1 - back]) << back;
+  }
+}
+
+}  // namespace
+}  // namespace chip8
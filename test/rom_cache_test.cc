@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "rom_cache.h"
+
+namespace chip8 {
+namespace {
+
+const std::string kProgramsDir{ CHIP8_PROGRAMS_DIR };
+
+TEST(RomCacheTest, SharesOneRomAcrossPathsToTheSameFile) {
+  const std::filesystem::path rom{ kProgramsDir + "/LogoIBM.ch8" };
+  const std::filesystem::path link{ std::filesystem::temp_directory_path() / "chip8_rom_cache_test.ch8" };
+  std::filesystem::remove(link);
+  std::filesystem::create_symlink(std::filesystem::absolute(rom), link);
+
+  const std::shared_ptr<const Rom> direct{ RomCache::Instance().Load(rom.string()) };
+  const std::shared_ptr<const Rom> linked{ RomCache::Instance().Load(link.string()) };
+  std::filesystem::remove(link);
+
+  EXPECT_EQ(direct, linked);
+  EXPECT_EQ(direct->Size(), std::filesystem::file_size(rom));
+}
+
+TEST(RomCacheTest, EvictsLeastRecentlyLoadedBeyondCapacity) {
+  RomCache& cache{ RomCache::Instance() };
+  cache.SetCapacity(2);
+  const std::shared_ptr<const Rom> first{ cache.Load(kProgramsDir + "/LogoIBM.ch8") };
+  cache.Load(kProgramsDir + "/Brix.ch8");
+  cache.Load(kProgramsDir + "/Maze(DW).ch8");
+  EXPECT_EQ(cache.Size(), 2u);
+
+  // Evicted, so loaded afresh; the ROM handed out before stays valid.
+  EXPECT_NE(cache.Load(kProgramsDir + "/LogoIBM.ch8"), first);
+  EXPECT_EQ(first->Memory()[Emulator::kChip8ProgramStartAddress], 0x00);
+  cache.SetCapacity(RomCache::kDefaultCapacity);
+}
+
+}  // namespace
+}  // namespace chip8
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "emulator.h"
+#include "headless.h"
+#include "save_state.h"
+
+namespace chip8 {
+namespace {
+
+const std::string kRom{ std::string{ CHIP8_PROGRAMS_DIR } + "/Trip8Demo.ch8" };
+
+struct Instance {
+  explicit Instance(const std::string& rom) : emulator{ rom, screen, speaker, keyboard } { emulator.Seed(7); }
+
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  Emulator emulator;
+};
+
+TEST(SaveStateTest, CompressedSnapshotRestoresTheSameMachineState) {
+  Instance fresh{ kRom };
+  const SaveState base{ fresh.emulator.Snapshot() };
+
+  Instance running{ kRom };
+  for (int frame = 0; frame < 120; ++frame) {
+    running.emulator.RunFrame();
+  }
+  const std::vector<uint8_t> encoded{ CompressSaveState(running.emulator.Snapshot(), base) };
+  EXPECT_LT(encoded.size(), sizeof(SaveState));
+
+  Instance restored{ kRom };
+  restored.emulator.Restore(DecompressSaveState(encoded, base));
+  EXPECT_EQ(restored.emulator.CaptureState(), running.emulator.CaptureState());
+  EXPECT_EQ(restored.emulator.Cycles(), running.emulator.Cycles());
+
+  // The virtual clock comes along, so both keep running in step.
+  for (int frame = 0; frame < 60; ++frame) {
+    running.emulator.RunFrame();
+    restored.emulator.RunFrame();
+  }
+  EXPECT_EQ(restored.emulator.CaptureState(), running.emulator.CaptureState());
+}
+
+TEST(SaveStateTest, DecompressRejectsTruncatedAndCorruptEncodings) {
+  Instance instance{ kRom };
+  const SaveState base{ instance.emulator.Snapshot() };
+  instance.emulator.RunFrame();
+  const std::vector<uint8_t> encoded{ CompressSaveState(instance.emulator.Snapshot(), base) };
+
+  for (size_t size = 0; size < encoded.size(); ++size) {
+    EXPECT_THROW(DecompressSaveState(std::span{ encoded }.first(size), base), std::invalid_argument) << size;
+  }
+
+  // An unchanged run reaching past the end of the state.
+  std::vector<uint8_t> overlong{ encoded };
+  overlong[0] = 0xFF;
+  overlong[1] = 0xFF;
+  EXPECT_THROW(DecompressSaveState(overlong, base), std::invalid_argument);
+}
+
+TEST(SaveStateTest, RestoreRejectsForeignAndOutOfRangeStates) {
+  Instance instance{ kRom };
+  const SaveState good{ instance.emulator.Snapshot() };
+
+  SaveState bad_magic{ good };
+  bad_magic.magic ^= 1;
+  EXPECT_THROW(instance.emulator.Restore(bad_magic), std::invalid_argument);
+
+  SaveState bad_version{ good };
+  bad_version.version = SaveState::kVersion + 1;
+  EXPECT_THROW(instance.emulator.Restore(bad_version), std::invalid_argument);
+
+  SaveState bad_key_wait{ good };
+  bad_key_wait.key_wait = 0x40;
+  EXPECT_THROW(instance.emulator.Restore(bad_key_wait), std::invalid_argument);
+
+  // kModernQuirks has no high resolution display.
+  SaveState hires{ good };
+  hires.hires = 1;
+  EXPECT_THROW(instance.emulator.Restore(hires), std::invalid_argument);
+
+  // A rejected state leaves the instance untouched.
+  EXPECT_EQ(instance.emulator.Snapshot(), good);
+}
+
+}  // namespace
+}  // namespace chip8
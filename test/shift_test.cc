@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include "emulator.h"
+#include "headless.h"
+#include "lockstep.h"
+#include "machine_state.h"
+#include "quirks.h"
+
+namespace chip8 {
+namespace {
+
+const std::string kRom{ std::string{ CHIP8_PROGRAMS_DIR } + "/LogoIBM.ch8" };
+
+// V1 = `value`, then 8XYE with x = y = 1 so the shift reads the same register under every profile.
+template <Quirks kQuirks>
+MachineState ShiftLeft(uint8_t value) {
+  MemoryScreen screen;
+  NullSpeaker speaker;
+  MemoryKeyboard keyboard;
+  BasicEmulator<kQuirks> emulator{ kRom, screen, speaker, keyboard };
+  emulator.ExecuteOpcode(0x6100 | value);
+  emulator.ExecuteOpcode(0x811E);
+  return emulator.CaptureState();
+}
+
+TEST(ShiftTest, ShiftLeftSetsVfFromTheMostSignificantBit) {
+#define CHIP8_EXPECT_SHIFT_LEFT(profile, name)                          \
+  {                                                                     \
+    const MachineState carry{ ShiftLeft<profile>(0x80) };               \
+    EXPECT_EQ(carry.variable_registers[0x1], 0x00) << name;             \
+    EXPECT_EQ(carry.variable_registers[0xF], 1) << name;                \
+    const MachineState no_carry{ ShiftLeft<profile>(0x48) };            \
+    EXPECT_EQ(no_carry.variable_registers[0x1], 0x90) << name;          \
+    EXPECT_EQ(no_carry.variable_registers[0xF], 0) << name;             \
+  }
+  CHIP8_QUIRK_PROFILES(CHIP8_EXPECT_SHIFT_LEFT)
+#undef CHIP8_EXPECT_SHIFT_LEFT
+}
+
+TEST(ShiftTest, LockstepShiftLeftSetsVfFromTheMostSignificantBit) {
+  MachineState initial;
+  initial.program_counter = Emulator::kChip8ProgramStartAddress;
+  const uint8_t program[]{ 0x61, 0x80, 0x81, 0x1E, 0x62, 0x48, 0x82, 0x2E };
+  for (size_t i = 0; i < sizeof(program); ++i) {
+    initial.memory[Emulator::kChip8ProgramStartAddress + i] = program[i];
+  }
+
+  LockstepEngine lockstep{ initial, 2 };
+  lockstep.Step();
+  lockstep.Step();
+  EXPECT_EQ(lockstep.CaptureState(1).variable_registers[0x1], 0x00);
+  EXPECT_EQ(lockstep.CaptureState(1).variable_registers[0xF], 1);
+  lockstep.Step();
+  lockstep.Step();
+  EXPECT_EQ(lockstep.CaptureState(1).variable_registers[0x2], 0x90);
+  EXPECT_EQ(lockstep.CaptureState(1).variable_registers[0xF], 0);
+}
+
+}  // namespace
+}  // namespace chip8